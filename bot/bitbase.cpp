@@ -0,0 +1,391 @@
+#include "bitbase.h"
+#include "../chess/game.h"
+#include "../chess/utils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <vector>
+#include <sys/stat.h>
+
+// Every bitbase is indexed the same way, with the stronger side normalized to white (pawns move up the board):
+//     index = ((strong_to_move * 64 + strong_king) * 64 + weak_king) * 64 + piece
+// One bit per position: set if the stronger side wins with best play.
+static const int BITBASE_SIZE = 2 * 64 * 64 * 64;
+static const uint32_t BITBASE_MAGIC = 0x42424350; // "PCBB"
+static const uint32_t BITBASE_VERSION = 1;
+
+static const double BITBASE_WIN_SCORE = 50000.0;
+
+static const char* bitbase_names[NUM_BITBASE_ENDINGS] = {"kpk", "krk", "kqk"};
+
+static std::string bitbase_directory = "bitbases";
+static std::vector<uint64_t> bitbases[NUM_BITBASE_ENDINGS];
+static std::once_flag bitbase_once[NUM_BITBASE_ENDINGS];
+
+enum GeneratorResult : uint8_t {
+    GEN_INVALID,
+    GEN_UNKNOWN,
+    GEN_DRAW,
+    GEN_WIN
+};
+
+static inline uint64_t square_bit(int square) {
+    return 1ULL << square;
+}
+
+static inline int square_distance(int a, int b) {
+    return std::max(std::abs(a % 8 - b % 8), std::abs(a / 8 - b / 8));
+}
+
+static inline int bitbase_index(int strong_to_move, int strong_king, int weak_king, int piece) {
+    return ((strong_to_move * 64 + strong_king) * 64 + weak_king) * 64 + piece;
+}
+
+static uint64_t king_attacks(int square) {
+    uint64_t attacks = 0;
+    for (int other = 0; other < 64; other++) {
+        if (square_distance(square, other) == 1) {
+            attacks |= square_bit(other);
+        }
+    }
+    return attacks;
+}
+
+// Squares attacked by the stronger side's extra piece ('occupied' blocks sliders).
+static uint64_t piece_attacks(BitbaseEnding ending, int square, uint64_t occupied) {
+    int file = square % 8;
+    int rank = square / 8;
+
+    if (ending == KPK) {
+        uint64_t attacks = 0;
+        if (rank < 7 && file > 0) { attacks |= square_bit(square + 7); }
+        if (rank < 7 && file < 7) { attacks |= square_bit(square + 9); }
+        return attacks;
+    }
+
+    static const int straight[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    static const int diagonal[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+    uint64_t attacks = 0;
+    for (int d = 0; d < 8; d++) {
+        if (d >= 4 && ending != KQK) {
+            break;
+        }
+        const int* delta = (d < 4) ? straight[d] : diagonal[d - 4];
+        int f = file + delta[0];
+        int r = rank + delta[1];
+        while (f >= 0 && f < 8 && r >= 0 && r < 8) {
+            attacks |= square_bit(r * 8 + f);
+            if (occupied & square_bit(r * 8 + f)) {
+                break;
+            }
+            f += delta[0];
+            r += delta[1];
+        }
+    }
+    return attacks;
+}
+
+static GeneratorResult initial_result(BitbaseEnding ending, const uint64_t* king_table, int strong_to_move,
+                                      int strong_king, int weak_king, int piece) {
+    if (strong_king == weak_king || strong_king == piece || weak_king == piece) {
+        return GEN_INVALID;
+    }
+    if (square_distance(strong_king, weak_king) <= 1) {
+        return GEN_INVALID;
+    }
+    if (ending == KPK && (piece / 8 == 0 || piece / 8 == 7)) {
+        return GEN_INVALID;
+    }
+
+    uint64_t occupied = square_bit(strong_king) | square_bit(weak_king) | square_bit(piece);
+    bool weak_in_check = piece_attacks(ending, piece, occupied) & square_bit(weak_king);
+    if (strong_to_move && weak_in_check) {
+        return GEN_INVALID; // weak side left its king in check
+    }
+
+    if (strong_to_move) {
+        // A pawn on the seventh promotes for free if the queening square is safe
+        int queening_square = piece + 8;
+        if (ending == KPK && piece / 8 == 6 && strong_king != queening_square &&
+                (square_distance(weak_king, queening_square) > 1 || square_distance(strong_king, queening_square) == 1)) {
+            return GEN_WIN;
+        }
+        return GEN_UNKNOWN;
+    }
+
+    // Weak side to move: capturing an undefended piece draws, no moves at all is mate or stalemate
+    uint64_t defended = king_table[strong_king];
+    uint64_t attacked = defended | piece_attacks(ending, piece, square_bit(strong_king));
+    uint64_t moves = king_table[weak_king];
+    if ((moves & square_bit(piece)) && !(defended & square_bit(piece))) {
+        return GEN_DRAW;
+    }
+    if (!(moves & ~attacked & ~square_bit(piece))) {
+        return weak_in_check ? GEN_WIN : GEN_DRAW;
+    }
+    return GEN_UNKNOWN;
+}
+
+static GeneratorResult classify(BitbaseEnding ending, const uint64_t* king_table, const std::vector<GeneratorResult>& results,
+                                int strong_to_move, int strong_king, int weak_king, int piece) {
+    bool any_unknown = false;
+
+    if (!strong_to_move) {
+        // Weak side: one drawing escape is enough, otherwise it's lost once every escape is known to lose
+        uint64_t attacked = king_table[strong_king] | piece_attacks(ending, piece, square_bit(strong_king));
+        uint64_t moves = king_table[weak_king] & ~attacked & ~square_bit(piece);
+        for (int dst = 0; dst < 64; dst++) {
+            if (!(moves & square_bit(dst))) {
+                continue;
+            }
+            GeneratorResult child = results[bitbase_index(1, strong_king, dst, piece)];
+            if (child == GEN_DRAW) {
+                return GEN_DRAW;
+            }
+            any_unknown |= (child == GEN_UNKNOWN);
+        }
+        return any_unknown ? GEN_UNKNOWN : GEN_WIN;
+    }
+
+    // Strong side: one winning move is enough, otherwise it's a draw once every move is known to draw
+    uint64_t king_moves = king_table[strong_king] & ~king_table[weak_king] & ~square_bit(piece);
+    for (int dst = 0; dst < 64; dst++) {
+        if (!(king_moves & square_bit(dst))) {
+            continue;
+        }
+        GeneratorResult child = results[bitbase_index(0, dst, weak_king, piece)];
+        if (child == GEN_WIN) {
+            return GEN_WIN;
+        }
+        any_unknown |= (child == GEN_UNKNOWN);
+    }
+
+    uint64_t kings = square_bit(strong_king) | square_bit(weak_king);
+    uint64_t piece_moves = 0;
+    if (ending == KPK) {
+        // Promotions are covered by the initial pass, so only pushes below the seventh rank matter here
+        int push = piece + 8;
+        if (piece / 8 < 6 && !(kings & square_bit(push))) {
+            piece_moves |= square_bit(push);
+            if (piece / 8 == 1 && !(kings & square_bit(push + 8))) {
+                piece_moves |= square_bit(push + 8);
+            }
+        }
+    } else {
+        piece_moves = piece_attacks(ending, piece, kings) & ~kings;
+    }
+
+    for (int dst = 0; dst < 64; dst++) {
+        if (!(piece_moves & square_bit(dst))) {
+            continue;
+        }
+        GeneratorResult child = results[bitbase_index(0, strong_king, weak_king, dst)];
+        if (child == GEN_WIN) {
+            return GEN_WIN;
+        }
+        any_unknown |= (child == GEN_UNKNOWN);
+    }
+
+    return any_unknown ? GEN_UNKNOWN : GEN_DRAW;
+}
+
+// Retrograde analysis by repeated passes: keep resolving unknown positions from their children until nothing changes.
+// Whatever is still unknown at the end can't be forced to a win, so it's a draw.
+static std::vector<uint64_t> generate_bitbase(BitbaseEnding ending) {
+    uint64_t king_table[64];
+    for (int square = 0; square < 64; square++) {
+        king_table[square] = king_attacks(square);
+    }
+
+    std::vector<GeneratorResult> results(BITBASE_SIZE);
+    for (int index = 0; index < BITBASE_SIZE; index++) {
+        int piece = index % 64;
+        int weak_king = (index / 64) % 64;
+        int strong_king = (index / 4096) % 64;
+        int strong_to_move = index / 262144;
+        results[index] = initial_result(ending, king_table, strong_to_move, strong_king, weak_king, piece);
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int index = 0; index < BITBASE_SIZE; index++) {
+            if (results[index] != GEN_UNKNOWN) {
+                continue;
+            }
+            int piece = index % 64;
+            int weak_king = (index / 64) % 64;
+            int strong_king = (index / 4096) % 64;
+            int strong_to_move = index / 262144;
+            GeneratorResult result = classify(ending, king_table, results, strong_to_move, strong_king, weak_king, piece);
+            if (result != GEN_UNKNOWN) {
+                results[index] = result;
+                changed = true;
+            }
+        }
+    }
+
+    std::vector<uint64_t> bits(BITBASE_SIZE / 64, 0);
+    for (int index = 0; index < BITBASE_SIZE; index++) {
+        if (results[index] == GEN_WIN) {
+            bits[index / 64] |= square_bit(index % 64);
+        }
+    }
+    return bits;
+}
+
+static std::string bitbase_path(BitbaseEnding ending) {
+    return bitbase_directory + "/" + bitbase_names[ending] + ".bb";
+}
+
+static bool load_bitbase(BitbaseEnding ending, std::vector<uint64_t>& bits) {
+    std::ifstream in(bitbase_path(ending), std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    uint32_t header[3];
+    in.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!in || header[0] != BITBASE_MAGIC || header[1] != BITBASE_VERSION || header[2] != (uint32_t) ending) {
+        return false;
+    }
+
+    bits.assign(BITBASE_SIZE / 64, 0);
+    in.read(reinterpret_cast<char*>(bits.data()), bits.size() * sizeof(uint64_t));
+    return (bool) in;
+}
+
+static void save_bitbase(BitbaseEnding ending, const std::vector<uint64_t>& bits) {
+    mkdir(bitbase_directory.c_str(), 0755);
+
+    std::ofstream out(bitbase_path(ending), std::ios::binary);
+    if (!out) {
+        debug_log("Could not cache bitbase to " + bitbase_path(ending));
+        return;
+    }
+
+    uint32_t header[3] = {BITBASE_MAGIC, BITBASE_VERSION, (uint32_t) ending};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(bits.data()), bits.size() * sizeof(uint64_t));
+}
+
+static const std::vector<uint64_t>& get_bitbase(BitbaseEnding ending) {
+    std::call_once(bitbase_once[ending], [ending]() {
+        if (!load_bitbase(ending, bitbases[ending])) {
+            bitbases[ending] = generate_bitbase(ending);
+            save_bitbase(ending, bitbases[ending]);
+        }
+    });
+    return bitbases[ending];
+}
+
+void set_bitbase_directory(const std::string& directory) {
+    bitbase_directory = directory;
+}
+
+void init_bitbases() {
+    for (int ending = 0; ending < NUM_BITBASE_ENDINGS; ending++) {
+        get_bitbase((BitbaseEnding) ending);
+    }
+}
+
+// Finds the ending on the board, normalized so the stronger side is white. Returns false if no bitbase covers it.
+static bool locate_ending(Board& board, BitbaseEnding& ending, Color& strong_side,
+                          int& strong_king, int& weak_king, int& piece) {
+    int white_king = -1;
+    int black_king = -1;
+    int extra = -1;
+    Piece extra_piece = EMPTY;
+
+    for (int index = 0; index < 64; index++) {
+        Piece p = board.get_piece(index % 8, index / 8);
+        if (p == EMPTY) {
+            continue;
+        } else if (p == WHITE_KING) {
+            white_king = index;
+        } else if (p == BLACK_KING) {
+            black_king = index;
+        } else if (extra == -1) {
+            extra = index;
+            extra_piece = p;
+        } else {
+            return false; // more than three pieces
+        }
+    }
+
+    if (extra == -1 || white_king == -1 || black_king == -1) {
+        return false;
+    }
+
+    switch (extra_piece) {
+        case WHITE_PAWN:  case BLACK_PAWN:  ending = KPK; break;
+        case WHITE_ROOK:  case BLACK_ROOK:  ending = KRK; break;
+        case WHITE_QUEEN: case BLACK_QUEEN: ending = KQK; break;
+        default: return false;
+    }
+
+    strong_side = (extra_piece >= WHITE_PAWN && extra_piece <= WHITE_KING) ? WHITE : BLACK;
+    if (strong_side == WHITE) {
+        strong_king = white_king;
+        weak_king = black_king;
+        piece = extra;
+    } else {
+        // Flip the board vertically so black's pawn moves up like a white one
+        strong_king = black_king ^ 56;
+        weak_king = white_king ^ 56;
+        piece = extra ^ 56;
+    }
+    return true;
+}
+
+BitbaseResult probe_bitbase(Board& board, Color player_to_move) {
+    BitbaseEnding ending;
+    Color strong_side;
+    int strong_king, weak_king, piece;
+    if (!locate_ending(board, ending, strong_side, strong_king, weak_king, piece)) {
+        return BITBASE_UNKNOWN;
+    }
+
+    int strong_to_move = (player_to_move == strong_side) ? 1 : 0;
+    int index = bitbase_index(strong_to_move, strong_king, weak_king, piece);
+    bool strong_wins = get_bitbase(ending)[index / 64] & square_bit(index % 64);
+
+    if (!strong_wins) {
+        return BITBASE_DRAW;
+    }
+    return strong_to_move ? BITBASE_WIN : BITBASE_LOSS;
+}
+
+bool probe_bitbase_score(Board& board, Color player_to_move, double& score) {
+    BitbaseEnding ending;
+    Color strong_side;
+    int strong_king, weak_king, piece;
+    if (!locate_ending(board, ending, strong_side, strong_king, weak_king, piece)) {
+        return false;
+    }
+
+    BitbaseResult result = probe_bitbase(board, player_to_move);
+    if (result == BITBASE_DRAW) {
+        score = 0.0;
+        return true;
+    }
+
+    // Progress: push pawns up the board, or drive the lone king to the edge and bring our king closer
+    double progress = 0.0;
+    if (ending == KPK) {
+        progress = 10.0 * (piece / 8) + 2.0 * (7 - square_distance(strong_king, piece));
+    } else {
+        int file = weak_king % 8;
+        int rank = weak_king / 8;
+        int center_distance = std::max(3 - file, file - 4) + std::max(3 - rank, rank - 4);
+        progress = 10.0 * center_distance + 4.0 * (7 - square_distance(strong_king, weak_king));
+    }
+
+    score = BITBASE_WIN_SCORE + progress;
+    if (strong_side == BLACK) {
+        score = -score;
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef BOT_BITBASE_H
+#define BOT_BITBASE_H
+#include "../chess/board.h"
+#include <cstdint>
+#include <string>
+
+// Win/draw bitbases for king + one piece vs. lone king endings. Tables are built by retrograde analysis the first
+// time they're needed and cached to disk (see set_bitbase_directory), so no external tablebase files are needed.
+enum BitbaseEnding : uint8_t {
+    KPK,
+    KRK,
+    KQK,
+    NUM_BITBASE_ENDINGS
+};
+
+enum BitbaseResult : uint8_t {
+    BITBASE_UNKNOWN, // position isn't covered by any bitbase
+    BITBASE_DRAW,
+    BITBASE_WIN,     // win for the side to move
+    BITBASE_LOSS     // loss for the side to move
+};
+
+// Directory the generated bitbases are cached in (created on demand). Defaults to "bitbases".
+void set_bitbase_directory(const std::string& directory);
+
+// Builds (or loads) every bitbase up front instead of on first probe.
+void init_bitbases();
+
+BitbaseResult probe_bitbase(Board& board, Color player_to_move);
+
+// Same as probe_bitbase, but as a white-relative score for the search (0 for draws, a large score for wins that
+// also rewards progress, so the bot doesn't shuffle around in a won ending).
+bool probe_bitbase_score(Board& board, Color player_to_move, double& score);
+
+#endif
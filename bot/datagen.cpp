@@ -0,0 +1,192 @@
+#include "datagen.h"
+#include "driver.h"
+#include "eval_cache.h"
+#include "numa.h"
+#include "bitbase.h"
+#include "../chess/board.h"
+#include "../chess/game.h"
+#include "../chess/packed_position.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+using std::cout, std::endl;
+
+struct DatagenOptions {
+    int games;
+    int depth;
+    uint64_t nodes;
+    int random_plies;
+    int min_ply;
+    int max_plies;
+    EvalParams eval_params;
+};
+
+static bool is_quiet_move(Board& board, const Move& move, Color player) {
+    std::string notation = move.get_move();
+    if (notation.size() < 4) {
+        return true; // castling
+    }
+    if (notation.size() > 4) {
+        return false; // under-promotion
+    }
+    Piece piece = board.get_piece(notation[0] - 'a', notation[1] - '1');
+    int dst_rank = notation[3] - '1';
+    bool is_pawn = (piece == WHITE_PAWN || piece == BLACK_PAWN);
+    bool is_capture = board.get_piece(notation[2] - 'a', dst_rank) != EMPTY || (is_pawn && notation[0] != notation[2]);
+    bool is_promotion = is_pawn && dst_rank == ((player == WHITE) ? 7 : 0);
+    return !is_capture && !is_promotion;
+}
+
+// Plays 'random_plies' random legal moves from the start position; false if the game ended on the way.
+static bool random_opening(Board& board, Color& player, int random_plies, std::mt19937_64& rng) {
+    board = Board();
+    player = WHITE;
+    for (int ply = 0; ply < random_plies; ply++) {
+        vector<Move> legal_moves = board.get_legal_moves(player);
+        if (legal_moves.empty()) {
+            return false;
+        }
+        Move move = legal_moves[std::uniform_int_distribution<size_t>(0, legal_moves.size() - 1)(rng)];
+        board.update_move(move, player);
+        player = (player == WHITE) ? BLACK : WHITE;
+    }
+    return board.get_terminal_state(player) == NOT_TERMINAL;
+}
+
+// One self-play game; the quiet positions go to 'positions' with their result still unset. A game cut off at
+// 'max_plies' has no result (PACKED_NO_RESULT), rather than passing for a draw.
+static PackedResult play_datagen_game(Bot& bot, const DatagenOptions& options, std::mt19937_64& rng,
+                               std::vector<PackedPosition>& positions) {
+    Board board;
+    Color player;
+    while (!random_opening(board, player, options.random_plies, rng)) {}
+
+    for (int ply = 0; ply < options.max_plies; ply++) {
+        TerminalState state = board.get_terminal_state(player);
+        if (state == CHECKMATED) {
+            return (player == WHITE) ? PACKED_BLACK_WIN : PACKED_WHITE_WIN;
+        }
+        if (state == STALEMATED || fifty_move_rule_draw(board) || threefold_repetition_draw(board)) {
+            return PACKED_DRAW;
+        }
+
+        Move move = bot.request_move(board, player);
+        const SearchStats& stats = bot.get_search_stats();
+        if (ply >= options.min_ply && !stats.iterations.empty() && !board.is_checked(player) &&
+                is_quiet_move(board, move, player)) {
+            double score = stats.iterations.back().score;
+            if (std::abs(score) < 900000) {
+                // Search scores are in evaluation units, where a pawn is worth material_weight
+                double centipawns = 100.0 * score / options.eval_params.material_weight;
+                int16_t packed_score = std::max(-32000.0, std::min(32000.0, std::round(centipawns)));
+                positions.push_back(pack_position(board, player, packed_score, PACKED_NO_RESULT));
+            }
+        }
+
+        board.update_move(move, player);
+        player = (player == WHITE) ? BLACK : WHITE;
+    }
+    return PACKED_NO_RESULT;
+}
+
+void run_datagen(const std::vector<std::string>& args) {
+    std::map<std::string, std::string> options_by_key;
+    for (const std::string& arg : args) {
+        size_t equals = arg.find('=');
+        if (equals == std::string::npos) {
+            std::cerr << "Ignoring datagen argument '" << arg << "' (expected key=value)" << endl;
+            continue;
+        }
+        options_by_key[arg.substr(0, equals)] = arg.substr(equals + 1);
+    }
+    auto option = [&](const std::string& key, const std::string& fallback) {
+        return options_by_key.count(key) ? options_by_key[key] : fallback;
+    };
+
+    DatagenOptions options;
+    options.games = std::stoi(option("games", "1000"));
+    options.nodes = std::stoull(option("nodes", "0"));
+    options.depth = std::stoi(option("depth", options.nodes > 0 ? "64" : "3"));
+    options.random_plies = std::stoi(option("random_plies", "8"));
+    options.min_ply = std::stoi(option("min_ply", "16"));
+    options.max_plies = std::stoi(option("plies", "400"));
+    if (options_by_key.count("params") && !load_eval_params(options_by_key["params"], options.eval_params)) {
+        std::cerr << "Could not load parameters from " << options_by_key["params"] << endl;
+        return;
+    }
+    std::string out_path = option("out", "datagen.bin");
+    unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    int thread_count = std::max(1, std::stoi(option("threads", std::to_string(hardware_threads))));
+    ThreadAffinity affinity = AFFINITY_NONE;
+    if (!parse_thread_affinity(option("affinity", "none"), affinity)) {
+        std::cerr << "Unknown affinity '" << options_by_key["affinity"] << "' (expected none, compact or spread)" << endl;
+        return;
+    }
+
+    FILE* out = std::fopen(out_path.c_str(), "ab");
+    if (out == nullptr) {
+        std::cerr << "Could not open " << out_path << endl;
+        return;
+    }
+
+    init_bitbases();
+
+    std::atomic<int> next_game(0);
+    std::mutex output_mutex;
+    uint64_t total_positions = 0;
+    int finished_games = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    // Every worker evaluates with the same weights, so they can share one evaluation cache
+    EvalCache eval_cache(16);
+
+    auto worker = [&](int thread_index) {
+        // Pinned before the bot exists, so its table and stacks are allocated on this thread's node
+        pin_current_thread(thread_index, affinity);
+        std::mt19937_64 rng(std::random_device{}() + thread_index);
+        Bot bot(options.depth);
+        bot.set_eval_params(options.eval_params);
+        bot.set_search_limits(0.0, options.nodes);
+        bot.set_eval_cache(&eval_cache);
+
+        std::vector<PackedPosition> positions;
+        while (next_game++ < options.games) {
+            positions.clear();
+            bot.new_game();
+            PackedResult result = play_datagen_game(bot, options, rng, positions);
+            for (PackedPosition& position : positions) {
+                position.result = result;
+            }
+
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::fwrite(positions.data(), sizeof(PackedPosition), positions.size(), out);
+            total_positions += positions.size();
+            finished_games++;
+            if (finished_games % 100 == 0 || finished_games == options.games) {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                char line[128];
+                std::snprintf(line, sizeof(line), "Games %d: %llu positions, %.0f positions/hour",
+                              finished_games, (unsigned long long)total_positions, total_positions * 3600.0 / elapsed.count());
+                cout << line << endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; t++) {
+        threads.emplace_back(worker, t);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::fclose(out);
+
+    cout << "Wrote " << total_positions << " positions to " << out_path << endl;
+}
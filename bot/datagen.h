@@ -0,0 +1,15 @@
+#ifndef BOT_DATAGEN_H
+#define BOT_DATAGEN_H
+#include <string>
+#include <vector>
+
+// Self-play training data: plays bot-vs-bot games from randomized openings on all cores and appends the quiet
+// positions (not in check, best move not a capture or promotion, no mate score) to a packed position file,
+// each with its search score and the game's final result. Games cut off at plies= are labelled PACKED_NO_RESULT
+// (the tuner skips those), not draws. Arguments are key=value pairs:
+//   out=<file.bin>  games=<n>  threads=<n>  depth=<n>  nodes=<n per move>  params=<eval parameter file>
+//   random_plies=<random moves played before the bots take over>  min_ply=<first ply recorded>  plies=<max plies>
+//   affinity=<none|compact|spread>  pins worker threads to CPUs (see bot/numa.h), default none
+void run_datagen(const std::vector<std::string>& args);
+
+#endif
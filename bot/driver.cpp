@@ -1,142 +1,747 @@
-#include "../testing/debug.h"
 #include "../chess/board.h"
 #include "../chess/move.h"
 #include "../chess/game.h"
 #include "driver.h"
+#include "bitbase.h"
+#include "syzygy.h"
+#include "search_stats.h"
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <limits>
 #include <vector>
-#include <chrono>
 
-Bot::Bot() : max_depth(5),
-             material_weight(1.0), 
-             king_safety_weight(1.0) {}
+// Rough piece values for ordering captures
+static int piece_order_value(Piece piece) {
+    switch (piece) {
+        case WHITE_PAWN: case BLACK_PAWN: return 1;
+        case WHITE_KNIGHT: case BLACK_KNIGHT: return 3;
+        case WHITE_BISHOP: case BLACK_BISHOP: return 3;
+        case WHITE_ROOK: case BLACK_ROOK: return 5;
+        case WHITE_QUEEN: case BLACK_QUEEN: return 9;
+        case WHITE_KING: case BLACK_KING: return 10;
+        default: return 0;
+    }
+}
+
+// Quiet moves neither capture nor promote; castling counts as quiet, under-promotions don't
+static bool is_quiet_move(Board& board, const std::string& notation) {
+    if (notation.size() != 4) {
+        return notation.size() < 4;
+    }
+    Piece src_piece = board.get_piece(notation[0] - 'a', notation[1] - '1');
+    bool is_pawn = src_piece == WHITE_PAWN || src_piece == BLACK_PAWN;
+    int dst_rank = notation[3] - '1';
+    return board.get_piece(notation[2] - 'a', dst_rank) == EMPTY && !(is_pawn && (dst_rank == 0 || dst_rank == 7));
+}
+
+// Square a move captures on, or -1 (en passant and castling don't count)
+static int capture_square(Board& board, const Move& move) {
+    std::string notation = move.get_move();
+    if (notation.size() < 4 || board.get_piece(notation[2] - 'a', notation[3] - '1') == EMPTY) {
+        return -1;
+    }
+    return (notation[3] - '1') * 8 + (notation[2] - 'a');
+}
+
+// Mate scores (but not the infinite bounds of an open window), which pruning must never guess at
+static bool is_mate_bound(double score) {
+    return std::abs(score) > 900000 && !std::isinf(score);
+}
+
+Bot::Bot() : Bot(5, 1.0, 1.0) {}
 
-Bot::Bot(int max_depth) : max_depth(max_depth), 
-                          material_weight(1.0), 
-                          king_safety_weight(1.0) {}
+Bot::Bot(int max_depth) : Bot(max_depth, 1.0, 1.0) {}
 
 Bot::Bot(int max_depth, double material_weight, double king_safety_weight) : 
                           max_depth(max_depth),     
-                          material_weight(material_weight),
-                          king_safety_weight(king_safety_weight) {}
+                          opening_book(nullptr),
+                          book_depth(0),
+                          book_selection(BOOK_BEST_MOVE),
+                          rng(std::random_device{}()),
+                          tt(16),
+                          own_eval_cache(2),
+                          shared_eval_cache(nullptr),
+                          multi_pv(1),
+                          singular_search(false),
+                          search_depth(0),
+                          search_aborted(false),
+                          following_pv(false),
+                          killers(max_depth + extension_params.max_per_path + 2),
+                          last_search_ply(-1) {
+    eval_params.material_weight = material_weight;
+    eval_params.king_safety_weight = king_safety_weight;
+    std::fill(&history[0][0][0], &history[0][0][0] + 2 * 64 * 64, 0);
+}
+
+void Bot::set_eval_params(const EvalParams& params) {
+    this->eval_params = params;
+    eval_cache().clear();
+}
+
+void Bot::set_search_limits(double max_seconds, uint64_t max_nodes) {
+    limits.max_seconds = max_seconds;
+    limits.max_nodes = max_nodes;
+}
 
-int moves_evaluted = 0;
+void Bot::set_hash_size(size_t megabytes) {
+    tt.resize(megabytes);
+}
+
+void Bot::set_hash_placement(TTPlacement placement) {
+    tt.set_placement(placement);
+}
+
+void Bot::set_eval_cache_size(size_t megabytes) {
+    own_eval_cache.resize(megabytes);
+}
+
+void Bot::set_eval_cache(EvalCache* cache) {
+    shared_eval_cache = cache;
+}
+
+void Bot::new_game() {
+    tt.clear();
+    killers.assign(killers.size(), {});
+    std::fill(&history[0][0][0], &history[0][0][0] + 2 * 64 * 64, 0);
+    last_search_ply = -1;
+}
+
+void Bot::set_pruning_params(const PruningParams& params) {
+    this->pruning = params;
+}
+
+void Bot::set_extension_params(const ExtensionParams& params) {
+    this->extension_params = params;
+    killers.resize(max_depth + params.max_per_path + 2);
+}
+
+void Bot::set_multi_pv(int lines) {
+    this->multi_pv = std::max(1, lines);
+}
+
+void Bot::set_opening_book(const OpeningBook* book, int book_depth, BookSelection selection) {
+    this->opening_book = book;
+    this->book_depth = book_depth;
+    this->book_selection = selection;
+}
 
 Move Bot::request_move(Board& board, Color player) {
+    limits.start_clock();
+    search_aborted = false;
+    search_stats.reset();
+    search_counters.reset();
+    tt.new_search();
+    age_move_ordering(board.get_ply_count());
+
+    // Play straight out of the opening book while we're still in it
+    if (opening_book != nullptr && board.get_ply_count() < book_depth) {
+        Move book_move;
+        if (opening_book->probe(board, player, book_selection, rng, book_move)) {
+            return book_move;
+        }
+    }
+
     vector<Move> legal_moves = board.get_legal_moves(player);
-    Move best_move;
-
-    ////////////////////////////////////////// DEBUG INFO //////////////////////////////////////////
-    // auto DBG_timer_start = std::chrono::high_resolution_clock::now();
-    ////////////////////////////////////////// DEBUG INFO //////////////////////////////////////////
-
-    if (player == WHITE) { // WHITE: maximize the score
-        double best_move_score = -std::numeric_limits<double>::infinity();
-        for (Move& move : legal_moves) {
-            double move_score = evaluate_move(board, move, player, 1, 
-                                                -std::numeric_limits<double>::infinity(), 
-                                                std::numeric_limits<double>::infinity());
-            if (move_score > best_move_score) {
-                best_move_score = move_score;
-                best_move = move;
+
+    // In tablebase positions, only search the moves that keep the best result
+    filter_syzygy_root_moves(board, player, legal_moves);
+    if (legal_moves.size() <= 1) {
+        return legal_moves.empty() ? Move() : legal_moves[0];
+    }
+
+    search_counters.nodes++;
+    Move best_move = legal_moves[0];
+    pv_table.assign(max_depth + extension_params.max_per_path + 2, {});
+    previous_pv.clear();
+
+    // Iterative deepening: each finished iteration's lines are searched first in the next one, which lets the
+    // root window cut off the other moves sooner. An iteration cut short by the limits is thrown away.
+    for (search_depth = 1; search_depth <= max_depth; search_depth++) {
+
+        // Multi-PV: every pass searches the root moves not yet picked this iteration. The transposition table
+        // still holds the subtrees of the earlier passes, so later passes are much cheaper.
+        std::vector<PvLine> lines;
+        vector<Move> remaining_moves = legal_moves;
+        size_t num_lines = std::min<size_t>(multi_pv, legal_moves.size());
+        while (lines.size() < num_lines) {
+            std::vector<Move> line;
+            double line_score = search_root(board, player, remaining_moves, line);
+            if (search_aborted) {
+                break;
             }
+            lines.push_back({line_score, extend_pv(board, player, line)});
+            remaining_moves.erase(std::find_if(remaining_moves.begin(), remaining_moves.end(),
+                                  [&](const Move& move) { return move.get_move() == line[0].get_move(); }));
+        }
+        if (search_aborted) {
+            break;
+        }
+
+        best_move = Move(lines[0].moves[0]);
+        previous_pv.assign(lines[0].moves.begin(), lines[0].moves.end());
+        search_stats.iterations.push_back({search_depth, search_counters.nodes, limits.elapsed_seconds(), lines[0].score,
+                                           best_move.get_move(), lines});
+
+        for (size_t i = lines.size(); i-- > 0;) {
+            auto line_move = std::find_if(legal_moves.begin(), legal_moves.end(),
+                                          [&](const Move& move) { return move.get_move() == lines[i].moves[0]; });
+            std::rotate(legal_moves.begin(), line_move, line_move + 1);
+        }
+
+        // A forced mate won't get any shorter by searching deeper
+        if (std::abs(lines[0].score) > 900000) {
+            break;
+        }
+    }
+
+    // Collect this thread's counters into the report for the whole search
+    search_stats.totals.merge(search_counters);
+    search_stats.seconds = limits.elapsed_seconds();
+
+    return best_move;
+}
+
+double Bot::search_root(Board& board, Color player, vector<Move>& legal_moves, std::vector<Move>& best_line) {
+    STATS_INC(interior_nodes);
+    STATS_ADD(children_searched, legal_moves.size());
+
+    double alpha = -std::numeric_limits<double>::infinity();
+    double beta = std::numeric_limits<double>::infinity();
+    double best_move_score = (player == WHITE) ? -std::numeric_limits<double>::infinity()
+                                               : std::numeric_limits<double>::infinity();
+
+    CheckInfo check_info = board.get_check_info(player);
+    uint64_t root_key = board.get_hash(player);
+    for (Move& move : legal_moves) {
+        uint64_t key = board.hash_after_move(root_key, move, player);
+        tt.prefetch(key);
+        following_pv = !previous_pv.empty() && move.get_move() == previous_pv[0].get_move();
+        bool gives_check = board.gives_check(move, player, check_info);
+        double move_score = evaluate_move(board, move, player, 1, alpha, beta, gives_check,
+                                          extend(0, gives_check, false, false), key);
+        if (search_aborted) {
+            break;
         }
-    } else { // BLACK: minimize the score
-        double best_move_score = std::numeric_limits<double>::infinity();
-        for (Move& move : legal_moves) {
-            double move_score = evaluate_move(board, move, player, 1, 
-                                                -std::numeric_limits<double>::infinity(), 
-                                                std::numeric_limits<double>::infinity());
-            if (move_score < best_move_score) {
-                best_move_score = move_score;
-                best_move = move;
+
+        // WHITE maximizes the score, BLACK minimizes it
+        bool improved = (player == WHITE) ? move_score > best_move_score : move_score < best_move_score;
+        if (improved) {
+            best_move_score = move_score;
+            best_line = {move};
+            best_line.insert(best_line.end(), pv_table[1].begin(), pv_table[1].end());
+            if (player == WHITE) {
+                alpha = std::max(alpha, move_score);
+            } else {
+                beta = std::min(beta, move_score);
             }
         }
     }
+    return best_move_score;
+}
+
+// The triangular PV stops early where a transposition table hit cut the search short, so the rest of the
+// line is followed through the table's best moves.
+std::vector<std::string> Bot::extend_pv(Board& board, Color player, const std::vector<Move>& line) {
+    std::vector<std::string> pv;
+    Board position = board;
+    Color player_to_move = player;
+    for (const Move& move : line) {
+        pv.push_back(move.get_move());
+        position.update_move(move, player_to_move);
+        player_to_move = (player_to_move == WHITE) ? BLACK : WHITE;
+    }
+
+    while ((int) pv.size() < search_depth) {
+        TTEntry entry;
+        if (!tt.probe(position.get_hash(player_to_move), entry) || entry.move == 0) {
+            break;
+        }
+        Move move = unpack_tt_move(entry.move);
+        if (!position.is_legal_move(move, player_to_move)) {
+            break;
+        }
+        pv.push_back(move.get_move());
+        position.update_move(move, player_to_move);
+        player_to_move = (player_to_move == WHITE) ? BLACK : WHITE;
+    }
+    return pv;
+}
 
-    ////////////////////////////////////////// DEBUG INFO //////////////////////////////////////////
+// The killers of ply 'shift + d' in the previous search belong to ply 'd' of this one when the game has moved on
+// by 'shift' plies; history scores are halved so recent cutoffs outweigh old ones.
+void Bot::age_move_ordering(int root_ply) {
+    int shift = root_ply - last_search_ply;
+    if (last_search_ply < 0 || shift <= 0 || shift >= (int) killers.size()) {
+        killers.assign(killers.size(), {});
+    } else {
+        size_t size = killers.size();
+        killers.erase(killers.begin(), killers.begin() + shift);
+        killers.resize(size);
+    }
+    last_search_ply = root_ply;
 
-    // std::cout << std::endl << std::endl << std::endl << std::endl << std::endl << std::endl;
+    for (int* value = &history[0][0][0]; value != &history[0][0][0] + 2 * 64 * 64; value++) {
+        *value /= 2;
+    }
+}
 
-    // auto DBG_timer_end = std::chrono::high_resolution_clock::now();
-    // std::chrono::duration<double> elapsed = DBG_timer_end - DBG_timer_start;
-    // std::cout << moves_evaluted << " moves evaluted in " << elapsed.count() << " seconds." << std::endl;
-    // std::cout << moves_evaluted / elapsed.count() << " moves per second!" << std::endl;
+// Captures and queen promotions first (most valuable victim, then least valuable attacker), then the killers
+// of this ply, then the other quiet moves by history score
+void Bot::order_moves(Board& board, Color player, int depth, std::vector<Move>& moves) {
+    std::vector<std::pair<int, Move>> scored;
+    scored.reserve(moves.size());
+    for (Move& move : moves) {
+        std::string notation = move.get_move();
+        int score = 0;
+        if (!is_quiet_move(board, notation)) {
+            if (notation.size() == 4) {
+                Piece src_piece = board.get_piece(notation[0] - 'a', notation[1] - '1');
+                Piece dst_piece = board.get_piece(notation[2] - 'a', notation[3] - '1');
+                bool is_capture = dst_piece != EMPTY;
+                score = 1000000 + 10 * (piece_order_value(dst_piece) + (is_capture ? 0 : 9)) -
+                        piece_order_value(src_piece);
+            }
+        } else if (notation == killers[depth][0].get_move()) {
+            score = 900001;
+        } else if (notation == killers[depth][1].get_move()) {
+            score = 900000;
+        } else if (notation.size() == 4) {
+            int src = (notation[1] - '1') * 8 + (notation[0] - 'a');
+            int dst = (notation[3] - '1') * 8 + (notation[2] - 'a');
+            score = history[player][src][dst];
+        }
+        scored.push_back({score, move});
+    }
+    std::stable_sort(scored.begin(), scored.end(),
+                     [](const std::pair<int, Move>& a, const std::pair<int, Move>& b) { return a.first > b.first; });
+    for (size_t i = 0; i < moves.size(); i++) {
+        moves[i] = scored[i].second;
+    }
+}
 
-    // std::cout << std::endl << std::endl;
-    
-    // CallTracker::printStats("score");
-    // CallTracker::printStats("legal");
-    // std::cout << std::endl;
-    
-    ////////////////////////////////////////// DEBUG INFO //////////////////////////////////////////
+void Bot::record_cutoff(Board& board, Color player, int depth, int remaining_depth, const Move& move) {
+    std::string notation = move.get_move();
+    if (!is_quiet_move(board, notation)) {
+        return;
+    }
+    if (killers[depth][0].get_move() != notation) {
+        killers[depth][1] = killers[depth][0];
+        killers[depth][0] = move;
+    }
+    if (notation.size() == 4) {
+        int src = (notation[1] - '1') * 8 + (notation[0] - 'a');
+        int dst = (notation[3] - '1') * 8 + (notation[2] - 'a');
+        // Capped well below the killer scores
+        history[player][src][dst] = std::min(history[player][src][dst] + remaining_depth * remaining_depth, 1 << 16);
+    }
+}
 
+void Bot::update_pv(int depth, const Move& move) {
+    std::vector<Move>& line = pv_table[depth];
+    line.assign(1, move);
+    line.insert(line.end(), pv_table[depth + 1].begin(), pv_table[depth + 1].end());
+}
 
-    return best_move;
+bool Bot::limits_exceeded() {
+    return limits.exceeded(search_counters.nodes);
+}
+
+const SearchStats& Bot::get_search_stats() const {
+    return search_stats;
+}
+
+int Bot::extend(int extensions, bool gives_check, bool recapture, bool singular) {
+    int extension = 0;
+    if (gives_check && extension_params.check > 0) {
+        STATS_INC(check_extensions);
+        extension = std::max(extension, extension_params.check);
+    }
+    if (recapture && extension_params.recapture > 0) {
+        STATS_INC(recapture_extensions);
+        extension = std::max(extension, extension_params.recapture);
+    }
+    if (singular && extension_params.singular > 0) {
+        STATS_INC(singular_extensions);
+        extension = std::max(extension, extension_params.singular);
+    }
+    return std::min(extensions + extension, std::max(extensions, extension_params.max_per_path));
 }
 
-double Bot::evaluate_move(Board& board, Move& move, Color player, int depth, double alpha, double beta) {
+// Every move but the excluded one is searched with a null window just below 'singular_score', to half the
+// remaining depth; the first one to reach the score ends the test.
+bool Bot::is_singular(Board& board, Color player, std::vector<Move>& moves, const std::string& excluded,
+                      const LegalityInfo& legality, const CheckInfo& check_info, int depth, int extensions,
+                      uint64_t key, double singular_score) {
+    const double window = 1e-6;
+    double alpha = (player == WHITE) ? singular_score - window : singular_score;
+    double beta = (player == WHITE) ? singular_score : singular_score + window;
+    int reduced_extensions = extensions - (search_depth + extensions - depth) / 2;
+
+    singular_search = true;
+    bool singular = true;
+    for (Move& move : moves) {
+        if (move.get_move() == excluded || !board.is_pseudo_legal_move_legal(move, player, legality)) {
+            continue;
+        }
+        uint64_t child_key = board.hash_after_move(key, move, player);
+        tt.prefetch(child_key);
+        following_pv = false;
+        double eval = evaluate_move(board, move, player, depth + 1, alpha, beta,
+                                    board.gives_check(move, player, check_info), reduced_extensions, child_key);
+        if (search_aborted || (player == WHITE ? eval >= singular_score : eval <= singular_score)) {
+            singular = false;
+            break;
+        }
+    }
+    singular_search = false;
+    return singular;
+}
 
-    // moves_evaluted++;  // DEBUG
+double Bot::evaluate_move(Board& board, Move& move, Color player, int depth, double alpha, double beta, bool gives_check,
+                          int extensions, uint64_t key) {
+    search_counters.nodes++;
 
-    // Create a board after the move is played
+    // Out of time/nodes: unwind, the caller throws this iteration away
+    if (search_aborted || limits_exceeded()) {
+        search_aborted = true;
+        return 0.0;
+    }
+
+    // Nodes that return without searching have no line below them
+    bool on_previous_pv = following_pv;
+    following_pv = false;
+    pv_table[depth].clear();
+
+    // Create a board after the move is played (remembering where it captured, for recapture extensions)
+    int recapture_square = capture_square(board, move);
     Board board_after_move = board.inspect_move(move, player);
     Color player_to_move = player == WHITE ? BLACK : WHITE;
 
+    // Tablebase cutoff (only succeeds after captures/pawn moves once few enough pieces are left)
+    double tablebase_score;
+    if (probe_syzygy_score(board_after_move, player_to_move, depth, tablebase_score) &&
+            board_after_move.get_terminal_state(player_to_move) == NOT_TERMINAL) {
+        STATS_INC(tb_hits);
+        return tablebase_score;
+    }
+
     // Terminal condition: reached max search depth or no moves available
-    if (depth >= max_depth) {
-        // CallTracker::recordCall("start");
-        double score = board_after_move.score_position(player_to_move, depth, material_weight, king_safety_weight);
-        // CallTracker::recordCall("score");
-        return score;
+    if (depth >= search_depth + extensions) {
+        // Known endings get a perfect answer (mates are still left to score_position)
+        double bitbase_score;
+        if (probe_bitbase_score(board_after_move, player_to_move, bitbase_score) &&
+                board_after_move.get_terminal_state(player_to_move) == NOT_TERMINAL) {
+            STATS_INC(tb_hits);
+            return bitbase_score;
+        }
+
+        return score_leaf(board_after_move, player_to_move, depth, gives_check, key);
     }
 
-    // Get all legal moves
-    // CallTracker::recordCall("start");
-    std::vector<Move> legal_moves = board_after_move.get_legal_moves(player_to_move);
-    // CallTracker::recordCall("legal");
+    // No point searching a known draw any deeper
+    if (probe_bitbase(board_after_move, player_to_move) == BITBASE_DRAW) {
+        STATS_INC(tb_hits);
+        return 0.0;
+    }
 
-    // If no legal moves, score position!
-    if (legal_moves.empty()) {
-        return board_after_move.score_position(player_to_move, depth, material_weight, king_safety_weight);
+    // Transposition table: a deep enough result for this position may settle it, otherwise its best move
+    // is searched first
+    int remaining_depth = search_depth + extensions - depth;
+    TTEntry entry;
+    uint16_t tt_move = 0;
+    STATS_INC(tt_probes);
+    if (tt.probe(key, entry)) {
+        STATS_INC(tt_hits);
+        tt_move = entry.move;
+        if (entry.depth >= remaining_depth) {
+            double tt_score = score_from_tt(entry.score, depth);
+            if (entry.bound == TT_EXACT || (entry.bound == TT_LOWER && tt_score >= beta) ||
+                    (entry.bound == TT_UPPER && tt_score <= alpha)) {
+                return tt_score;
+            }
+        }
+    }
+
+    // Pruning near the horizon, from the static evaluation (never in check, on the previous PV or next to mate
+    // scores). 'ahead' and 'behind' are how many pawns the eval is above beta and below alpha for the side to move.
+    bool can_prune = !gives_check && !on_previous_pv && remaining_depth <= pruning.max_depth &&
+                     !is_mate_bound(alpha) && !is_mate_bound(beta);
+    double static_eval = 0.0;
+    double futility_margin = 0.0;
+    if (can_prune) {
+        static_eval = cached_evaluate(board_after_move, key);
+        double pawns = eval_params.material_weight;
+        double ahead = ((player_to_move == WHITE) ? static_eval - beta : alpha - static_eval) / pawns;
+        double behind = ((player_to_move == WHITE) ? alpha - static_eval : static_eval - beta) / pawns;
+
+        // Reverse futility: so far ahead that giving up a margin per ply would still beat beta
+        if (pruning.reverse_futility_margin > 0.0 && ahead >= pruning.reverse_futility_margin * remaining_depth) {
+            STATS_INC(reverse_futility_prunes);
+            return static_eval;
+        }
+
+        // Razoring: so far behind that only the captures could help, so check that they don't
+        if (pruning.razor_margin > 0.0 && behind >= pruning.razor_margin * remaining_depth) {
+            double razor_score = quiescence(board_after_move, player_to_move, alpha, beta);
+            if (player_to_move == WHITE ? razor_score <= alpha : razor_score >= beta) {
+                STATS_INC(razor_prunes);
+                return razor_score;
+            }
+        }
+
+        // Futility: quiet moves below are skipped when even a margin per ply wouldn't lift the eval to alpha
+        if (pruning.futility_margin > 0.0 && behind >= pruning.futility_margin * remaining_depth) {
+            futility_margin = pruning.futility_margin * remaining_depth * pawns;
+        }
     }
 
+    // Pseudo-legal moves: each one is only checked for legality right before it is searched, so the moves
+    // left over after a cutoff never pay for it
+    std::vector<Move> legal_moves = board_after_move.get_pseudo_legal_moves(player_to_move);
+    LegalityInfo legality = board_after_move.get_legality_info(player_to_move, gives_check);
+    CheckInfo check_info = board_after_move.get_check_info(player_to_move);
+
+    // Move ordering: the previous iteration's PV first, then the transposition table move, then the rest
+    order_moves(board_after_move, player_to_move, depth, legal_moves);
+    std::string tt_notation = (tt_move != 0) ? unpack_tt_move(tt_move).get_move() : "";
+    if (tt_move != 0) {
+        auto found = std::find_if(legal_moves.begin(), legal_moves.end(),
+                                  [&](const Move& move) { return move.get_move() == tt_notation; });
+        if (found != legal_moves.end()) {
+            std::rotate(legal_moves.begin(), found, found + 1);
+        }
+    }
+    bool pv_move_first = false;
+    if (on_previous_pv && depth < (int) previous_pv.size()) {
+        std::string pv_notation = previous_pv[depth].get_move();
+        auto found = std::find_if(legal_moves.begin(), legal_moves.end(),
+                                  [&](const Move& move) { return move.get_move() == pv_notation; });
+        if (found != legal_moves.end()) {
+            std::rotate(legal_moves.begin(), found, found + 1);
+            pv_move_first = true;
+        }
+    }
+
+    // Singular extension: a transposition table move that failed high (or was exact) deep enough is extended when
+    // no other move comes close to its score
+    bool tt_move_singular = false;
+    TTBound good_bound = (player_to_move == WHITE) ? TT_LOWER : TT_UPPER;
+    if (extension_params.singular > 0 && tt_move != 0 && !singular_search &&
+            remaining_depth >= extension_params.singular_min_depth && entry.depth >= remaining_depth - 2 &&
+            (entry.bound == TT_EXACT || entry.bound == good_bound)) {
+        double tt_score = score_from_tt(entry.score, depth);
+        if (!is_mate_bound(tt_score)) {
+            double margin = extension_params.singular_margin * eval_params.material_weight;
+            double singular_score = (player_to_move == WHITE) ? tt_score - margin : tt_score + margin;
+            tt_move_singular = is_singular(board_after_move, player_to_move, legal_moves, tt_notation, legality,
+                                           check_info, depth, extensions, key, singular_score);
+        }
+    }
+
+    STATS_INC(interior_nodes);
+
+    double original_alpha = alpha;
+    double original_beta = beta;
+    double best_eval;
+    size_t best_index = 0;
+    bool best_searched = false; // futility pruning only starts once a move has been searched
+    int legal_count = 0;
+
     // If player is WHITE, we assume WHITE is maximizing and BLACK is minimizing
     if (player_to_move == WHITE) {  
-        double max_eval = -std::numeric_limits<double>::infinity();
-        for (const Move& next_move : legal_moves) {
+        best_eval = -std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < legal_moves.size(); i++) {
+            if (!board_after_move.is_pseudo_legal_move_legal(legal_moves[i], player_to_move, legality)) {
+                continue;
+            }
+            legal_count++;
+            bool move_gives_check = board_after_move.gives_check(legal_moves[i], player_to_move, check_info);
+            if (futility_margin > 0.0 && best_searched && !move_gives_check &&
+                    is_quiet_move(board_after_move, legal_moves[i].get_move())) {
+                STATS_INC(futility_prunes);
+                best_eval = std::max(best_eval, static_eval + futility_margin);
+                continue;
+            }
+            // The child's table bucket starts loading before the move is even made
+            uint64_t child_key = board_after_move.hash_after_move(key, legal_moves[i], player_to_move);
+            tt.prefetch(child_key);
+            STATS_INC(children_searched);
+            following_pv = pv_move_first && i == 0;
+            bool recapture = recapture_square >= 0 && capture_square(board_after_move, legal_moves[i]) == recapture_square;
+            bool singular = tt_move_singular && legal_moves[i].get_move() == tt_notation;
             double eval = evaluate_move(board_after_move, 
-                                          const_cast<Move&>(next_move), 
+                                          legal_moves[i], 
                                           WHITE, 
                                           depth + 1, 
                                           alpha, 
-                                          beta);
-            max_eval = std::max(max_eval, eval);
+                                          beta,
+                                          move_gives_check,
+                                          extend(extensions, move_gives_check, recapture, singular),
+                                          child_key);
+            if (eval > best_eval) {
+                best_eval = eval;
+                best_index = i;
+                best_searched = true;
+                update_pv(depth, legal_moves[i]);
+            }
             alpha = std::max(alpha, eval);
             if (beta <= alpha) {
+                STATS_INC(cutoffs);
+                if (i == 0) { STATS_INC(first_move_cutoffs); }
+                record_cutoff(board_after_move, player_to_move, depth, remaining_depth, legal_moves[i]);
                 break;  // beta cut-off
             }
         }
-        return max_eval;
     } 
     // Otherwise, for BLACK, we minimize
     else {
-        double min_eval = std::numeric_limits<double>::infinity();
-        for (const Move& next_move : legal_moves) {
+        best_eval = std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < legal_moves.size(); i++) {
+            if (!board_after_move.is_pseudo_legal_move_legal(legal_moves[i], player_to_move, legality)) {
+                continue;
+            }
+            legal_count++;
+            bool move_gives_check = board_after_move.gives_check(legal_moves[i], player_to_move, check_info);
+            if (futility_margin > 0.0 && best_searched && !move_gives_check &&
+                    is_quiet_move(board_after_move, legal_moves[i].get_move())) {
+                STATS_INC(futility_prunes);
+                best_eval = std::min(best_eval, static_eval - futility_margin);
+                continue;
+            }
+            // The child's table bucket starts loading before the move is even made
+            uint64_t child_key = board_after_move.hash_after_move(key, legal_moves[i], player_to_move);
+            tt.prefetch(child_key);
+            STATS_INC(children_searched);
+            following_pv = pv_move_first && i == 0;
+            bool recapture = recapture_square >= 0 && capture_square(board_after_move, legal_moves[i]) == recapture_square;
+            bool singular = tt_move_singular && legal_moves[i].get_move() == tt_notation;
             double eval = evaluate_move(board_after_move, 
-                                          const_cast<Move&>(next_move), 
+                                          legal_moves[i], 
                                           BLACK, 
                                           depth + 1, 
                                           alpha, 
-                                          beta);
-            min_eval = std::min(min_eval, eval);
+                                          beta,
+                                          move_gives_check,
+                                          extend(extensions, move_gives_check, recapture, singular),
+                                          child_key);
+            if (eval < best_eval) {
+                best_eval = eval;
+                best_index = i;
+                best_searched = true;
+                update_pv(depth, legal_moves[i]);
+            }
             beta = std::min(beta, eval);
             if (beta <= alpha) {
+                STATS_INC(cutoffs);
+                if (i == 0) { STATS_INC(first_move_cutoffs); }
+                record_cutoff(board_after_move, player_to_move, depth, remaining_depth, legal_moves[i]);
                 break;  // alpha cut-off
             }
         }
-        return min_eval;
     }
+
+    // No legal moves: checkmate or stalemate
+    if (legal_count == 0) {
+        return board_after_move.score_position(player_to_move, depth, eval_params, gives_check);
+    }
+
+    // An aborted search returns garbage, which must not outlive it
+    if (!search_aborted) {
+        TTBound bound = (best_eval <= original_alpha) ? TT_UPPER : (best_eval >= original_beta) ? TT_LOWER : TT_EXACT;
+        tt.store(key, score_to_tt(best_eval, depth), bound, remaining_depth, legal_moves[best_index]);
+    }
+    return best_eval;
+}
+
+EvalCache& Bot::eval_cache() {
+    return (shared_eval_cache != nullptr) ? *shared_eval_cache : own_eval_cache;
+}
+
+double Bot::cached_evaluate(Board& board, uint64_t key) {
+    double score;
+    STATS_INC(eval_probes);
+    if (eval_cache().probe(key, score)) {
+        STATS_INC(eval_hits);
+        return score;
+    }
+    score = board.evaluate(eval_params);
+    eval_cache().store(key, score);
+    return score;
+}
+
+double Bot::score_leaf(Board& board, Color player_to_move, int depth, bool in_check, uint64_t key) {
+    // Mates and draws depend on the path (depth, repetitions), so only the static evaluation is cached
+    double score;
+    if (board.score_game_over(player_to_move, depth, in_check, score)) {
+        return score;
+    }
+    return cached_evaluate(board, key);
+}
+
+double Bot::quiescence(Board& board, Color player_to_move, double alpha, double beta, Board* leaf) {
+    STATS_INC(qnodes);
+
+    // Stand pat: the side to move doesn't have to capture
+    double best_score = cached_evaluate(board, board.get_hash(player_to_move));
+    if (leaf != nullptr) {
+        *leaf = board;
+    }
+    if (player_to_move == WHITE) {
+        if (best_score >= beta) { return best_score; }
+        alpha = std::max(alpha, best_score);
+    } else {
+        if (best_score <= alpha) { return best_score; }
+        beta = std::min(beta, best_score);
+    }
+
+    // Captures and queen promotions, most valuable victim (then least valuable attacker) first
+    Color opponent = (player_to_move == WHITE) ? BLACK : WHITE;
+    int back_rank = (player_to_move == WHITE) ? 7 : 0;
+    vector<std::pair<int, Move>> forcing_moves;
+    LegalityInfo legality = board.get_legality_info(player_to_move);
+    for (Move& move : board.get_pseudo_legal_moves(player_to_move)) {
+        std::string notation = move.get_move();
+        if (notation.size() != 4) {
+            continue; // castling and under-promotions are never forcing
+        }
+
+        Piece src_piece = board.get_piece(notation[0] - 'a', notation[1] - '1');
+        Piece dst_piece = board.get_piece(notation[2] - 'a', notation[3] - '1');
+        bool is_promotion = (src_piece == WHITE_PAWN || src_piece == BLACK_PAWN) && notation[3] - '1' == back_rank;
+        if (dst_piece == EMPTY && !is_promotion) {
+            continue;
+        }
+        int order = 10 * (piece_order_value(dst_piece) + (is_promotion ? 9 : 0)) - piece_order_value(src_piece);
+        forcing_moves.push_back({order, move});
+    }
+    std::stable_sort(forcing_moves.begin(), forcing_moves.end(),
+                     [](const std::pair<int, Move>& a, const std::pair<int, Move>& b) { return a.first > b.first; });
+
+    for (std::pair<int, Move>& forcing_move : forcing_moves) {
+        Move& move = forcing_move.second;
+        if (!board.is_pseudo_legal_move_legal(move, player_to_move, legality)) {
+            continue;
+        }
+        Board child = board.inspect_move(move, player_to_move);
+        Board child_leaf;
+        double score = quiescence(child, opponent, alpha, beta, (leaf != nullptr) ? &child_leaf : nullptr);
+
+        if (player_to_move == WHITE ? score > best_score : score < best_score) {
+            best_score = score;
+            if (leaf != nullptr) {
+                *leaf = child_leaf;
+            }
+        }
+        if (player_to_move == WHITE) {
+            alpha = std::max(alpha, score);
+        } else {
+            beta = std::min(beta, score);
+        }
+        if (beta <= alpha) {
+            break;
+        }
+    }
+
+    return best_score;
 }
@@ -1,21 +1,152 @@
 #ifndef BOT_DRIVER_H
 #define BOT_DRIVER_H
 #include "../chess/board.h"
+#include "eval_cache.h"
+#include "opening_book.h"
+#include "search_limits.h"
+#include "search_stats.h"
+#include "transposition_table.h"
+#include <array>
+#include <cstdint>
+#include <random>
+
+// Pruning close to the horizon, where 'remaining' plies are left to search. Margins are in pawns (scaled by the
+// evaluation's material_weight) per remaining ply; a margin of 0 turns its technique off, which is the default until
+// an SPRT with './app match' accepts them (futility 2, reverse futility 1.5 and razoring 3 are where to start).
+struct PruningParams {
+    int max_depth = 3;                    // only nodes with at most this many plies left are pruned
+    double futility_margin = 0.0;         // skip quiet moves when eval + margin * remaining can't reach alpha
+    double reverse_futility_margin = 0.0; // return the eval when eval - margin * remaining still beats beta
+    double razor_margin = 0.0;            // settle for the quiescence score when eval + margin * remaining is
+                                          // below alpha and the captures don't change that
+};
+
+// Extensions, in plies, that search forcing moves deeper than the rest: moves that give check, recaptures on the
+// square the previous move captured on, and transposition table moves that are singular (every other move, searched
+// to half the depth, falls 'singular_margin' pawns short of them). A move gets its largest extension, and a line is
+// never extended by more than 'max_per_path' plies in total. An extension of 0 turns it off, which is the default:
+// without a quiescence search at the leaves they haven't paid for their extra nodes yet (measure with
+// './app match' before turning them on).
+struct ExtensionParams {
+    int check = 0;
+    int recapture = 0;
+    int singular = 0;
+    int max_per_path = 2;
+    int singular_min_depth = 4;   // plies left before a singular extension is worth testing for
+    double singular_margin = 0.5;
+};
 
 class Bot {
 private:
     int max_depth;
-    double material_weight;
-    double king_safety_weight;
-    
-    double evaluate_move(Board& board, Move& move, Color player, int depth, double alpha, double beta);
+    EvalParams eval_params;
+
+    SearchLimits limits;
+
+    const OpeningBook* opening_book;
+    int book_depth;
+    BookSelection book_selection;
+    std::mt19937_64 rng;
+
+    SearchStats search_stats;
+    TranspositionTable tt;
+    EvalCache own_eval_cache;
+    EvalCache* shared_eval_cache; // used instead of own_eval_cache when set (see set_eval_cache)
+    int multi_pv;
+    PruningParams pruning;
+    ExtensionParams extension_params;
+    bool singular_search; // inside a singular extension test, which doesn't nest
+
+    int search_depth; // horizon of the current iteration
+    bool search_aborted;
+
+    bool limits_exceeded();
+    // Triangular PV table: pv_table[ply] is the best line found below the move played at 'ply', built up from
+    // pv_table[ply + 1] as the search returns
+    std::vector<std::vector<Move>> pv_table;
+    std::vector<Move> previous_pv; // best line of the last finished iteration, searched first in the next one
+    bool following_pv;             // is the node being entered still on previous_pv?
+
+    // Quiet moves that caused cutoffs, kept between searches: killers[ply] holds the last two at that ply and
+    // history[player][from][to] grows with the depth of every cutoff. Both are aged rather than cleared when the
+    // next search starts (see age_move_ordering), so later moves of a game start with warm tables.
+    std::vector<std::array<Move, 2>> killers;
+    int history[2][64][64];
+    int last_search_ply; // game ply of the previous search's root, -1 before the first search
+
+    void age_move_ordering(int root_ply);
+    void order_moves(Board& board, Color player, int depth, std::vector<Move>& moves);
+    void record_cutoff(Board& board, Color player, int depth, int remaining_depth, const Move& move);
+
+    // The horizon offset ('extensions') for a child of a node at offset 'extensions', within the per-path limit
+    int extend(int extensions, bool gives_check, bool recapture, bool singular);
+    // Whether no legal move other than 'excluded' reaches 'singular_score' (white-relative) for 'player'
+    bool is_singular(Board& board, Color player, std::vector<Move>& moves, const std::string& excluded,
+                     const LegalityInfo& legality, const CheckInfo& check_info, int depth, int extensions,
+                     uint64_t key, double singular_score);
+
+    double search_root(Board& board, Color player, vector<Move>& legal_moves, std::vector<Move>& best_line);
+    void update_pv(int depth, const Move& move);
+    std::vector<std::string> extend_pv(Board& board, Color player, const std::vector<Move>& line);
+    // Board::evaluate and Board::score_position, with the evaluation looked up in the evaluation cache first
+    // ('key' is the board's get_hash for the side to move)
+    EvalCache& eval_cache();
+    double cached_evaluate(Board& board, uint64_t key);
+    double score_leaf(Board& board, Color player_to_move, int depth, bool in_check, uint64_t key);
+
+    // 'gives_check' tells whether 'move' checks the opponent (see Board::gives_check). 'depth' is the ply of the
+    // position after 'move'; it is a leaf once 'depth' reaches search_depth + 'extensions'. 'key' is the hash of the
+    // position after 'move' (see Board::hash_after_move), whose table entry the caller has already prefetched.
+    double evaluate_move(Board& board, Move& move, Color player, int depth, double alpha, double beta, bool gives_check,
+                         int extensions, uint64_t key);
 
 public:
     Bot();
     Bot(int max_depth);
     Bot(int max_depth, double material_weight, double king_safety_weight);
 
+    // Replaces all evaluation weights, including the ones given to the constructor.
+    void set_eval_params(const EvalParams& params);
+
+    // Stop searching after 'max_seconds' or 'max_nodes' (0 = unlimited), keeping the deepest finished iteration.
+    void set_search_limits(double max_seconds, uint64_t max_nodes);
+
+    // Transposition table size (the table is cleared). Bots start with 16 MB.
+    void set_hash_size(size_t megabytes);
+    // Where the table's pages live on a NUMA machine (the table is cleared). Node-local suits a bot searching on
+    // one pinned thread, the default.
+    void set_hash_placement(TTPlacement placement);
+
+    // Evaluation cache size (the cache is cleared). Bots start with their own 2 MB cache.
+    void set_eval_cache_size(size_t megabytes);
+    // Evaluate through 'cache' instead, e.g. one cache shared by the bots of several threads that all use the
+    // same EvalParams (nullptr = back to the bot's own cache). The cache must outlive its use by the bot.
+    void set_eval_cache(EvalCache* cache);
+
+    // Forget everything learned from earlier searches (transposition table, killers and history). A bot kept
+    // for a whole game reuses all of it from one move to the next.
+    void new_game();
+
+    // Margins for futility pruning, reverse futility pruning and razoring (see PruningParams)
+    void set_pruning_params(const PruningParams& params);
+
+    // Check, recapture and singular extensions (see ExtensionParams)
+    void set_extension_params(const ExtensionParams& params);
+
+    // Search the best 'lines' root moves, each with its own score and principal variation (see SearchStats).
+    void set_multi_pv(int lines);
+
+    // Book moves are played (without searching) for the first 'book_depth' plies of the game.
+    void set_opening_book(const OpeningBook* book, int book_depth, BookSelection selection);
+
     Move request_move(Board& board, Color player);
+
+    // Static evaluation once the captures (and queen promotions) for 'player_to_move' have played out.
+    // 'leaf', if given, receives the quiet position the score comes from.
+    double quiescence(Board& board, Color player_to_move, double alpha, double beta, Board* leaf = nullptr);
+
+    // Statistics for the most recent request_move (detailed counters need a SEARCH_STATS build)
+    const SearchStats& get_search_stats() const;
 };
 
 #endif
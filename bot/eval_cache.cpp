@@ -0,0 +1,45 @@
+#include "eval_cache.h"
+#include "transposition_table.h"
+#include <cstring>
+
+static uint64_t score_bits(double score) {
+    uint64_t bits;
+    std::memcpy(&bits, &score, sizeof(bits));
+    return bits;
+}
+
+EvalCache::EvalCache(size_t megabytes) : mask(0) {
+    resize(megabytes);
+}
+
+void EvalCache::resize(size_t megabytes) {
+    size_t count = power_of_two_entries(megabytes, sizeof(EvalEntry));
+    entries = std::vector<EvalEntry>(count);
+    mask = count - 1;
+    clear();
+}
+
+void EvalCache::clear() {
+    // An empty slot only matches key 0 with a score of 0.0, which costs nothing if it ever happens
+    for (EvalEntry& entry : entries) {
+        entry.check.store(0, std::memory_order_relaxed);
+        entry.score.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool EvalCache::probe(uint64_t key, double& score) const {
+    const EvalEntry& entry = entries[key & mask];
+    uint64_t bits = entry.score.load(std::memory_order_relaxed);
+    if ((entry.check.load(std::memory_order_relaxed) ^ bits) != key) {
+        return false;
+    }
+    std::memcpy(&score, &bits, sizeof(score));
+    return true;
+}
+
+void EvalCache::store(uint64_t key, double score) {
+    EvalEntry& entry = entries[key & mask];
+    uint64_t bits = score_bits(score);
+    entry.check.store(key ^ bits, std::memory_order_relaxed);
+    entry.score.store(bits, std::memory_order_relaxed);
+}
@@ -0,0 +1,34 @@
+#ifndef BOT_EVAL_CACHE_H
+#define BOT_EVAL_CACHE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Static evaluations by Zobrist key, so a leaf reached again through another move order isn't evaluated twice.
+// There are no locks: each slot keeps the score next to (key ^ score), and a probe only hits when the two still
+// agree, so a slot torn by writers on other threads reads as a miss. One cache can be shared by every search thread
+// (see Bot::set_eval_cache) as long as they all evaluate with the same EvalParams.
+class EvalCache {
+private:
+    struct EvalEntry {
+        std::atomic<uint64_t> check; // key ^ score
+        std::atomic<uint64_t> score; // bits of the double score
+    };
+
+    std::vector<EvalEntry> entries;
+    size_t mask;
+
+public:
+    EvalCache(size_t megabytes);
+
+    // Size in megabytes, rounded down to a power of two entries (the cache is cleared)
+    void resize(size_t megabytes);
+    // Must be called whenever the evaluation weights change
+    void clear();
+
+    bool probe(uint64_t key, double& score) const;
+    void store(uint64_t key, double score);
+};
+
+#endif
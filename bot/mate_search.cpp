@@ -0,0 +1,176 @@
+#include "mate_search.h"
+#include "transposition_table.h"
+#include <algorithm>
+
+MateSearch::MateSearch(size_t megabytes) : nodes(0), aborted(false) {
+    size_t count = power_of_two_entries(megabytes, sizeof(MateEntry));
+    entries.assign(count, MateEntry{0, 0, 0, 0});
+    mask = count - 1;
+}
+
+void MateSearch::set_search_limits(double seconds, uint64_t node_limit) {
+    limits.max_seconds = seconds;
+    limits.max_nodes = node_limit;
+}
+
+MateSearch::MateEntry* MateSearch::probe(uint64_t key) {
+    MateEntry& slot = entries[key & mask];
+    return (slot.key == key) ? &slot : nullptr;
+}
+
+void MateSearch::store(uint64_t key, bool proven, int moves, const Move& move) {
+    // Entries are keyed with the attacker to move, so results stay valid across searches
+    MateEntry& slot = entries[key & mask];
+    if (slot.key != key) {
+        slot = MateEntry{key, 0, 0, 0};
+    }
+    if (proven) {
+        if (slot.proven == 0 || moves < slot.proven) {
+            slot.proven = static_cast<uint8_t>(moves);
+            slot.move = pack_tt_move(move);
+        }
+    } else {
+        slot.disproven = std::max(slot.disproven, static_cast<uint8_t>(moves));
+    }
+}
+
+bool MateSearch::limits_exceeded() {
+    return limits.exceeded(nodes);
+}
+
+std::vector<MateSearch::Check> MateSearch::ordered_checks(Board& board, Color attacker) {
+    Color defender = (attacker == WHITE) ? BLACK : WHITE;
+    std::vector<Check> checks;
+    CheckInfo check_info = board.get_check_info(attacker);
+    for (Move& move : board.get_legal_moves(attacker)) {
+        if (!board.gives_check(move, attacker, check_info)) {
+            continue;
+        }
+        Board position = board.inspect_move(move, attacker);
+        std::vector<Move> evasions = position.get_legal_moves(defender);
+        checks.push_back(Check{move, position, evasions});
+    }
+    std::stable_sort(checks.begin(), checks.end(), [](const Check& a, const Check& b) {
+        return a.evasions.size() < b.evasions.size();
+    });
+    return checks;
+}
+
+bool MateSearch::attack(Board& board, Color attacker, int moves, Move& best_move) {
+    nodes++;
+    if (aborted || limits_exceeded()) {
+        aborted = true;
+        return false;
+    }
+
+    uint64_t key = board.get_hash(attacker);
+    if (MateEntry* entry = probe(key)) {
+        if (entry->proven != 0 && entry->proven <= moves) {
+            best_move = unpack_tt_move(entry->move);
+            return true;
+        }
+        if (entry->disproven >= moves) {
+            return false;
+        }
+    }
+
+    for (const Check& check : ordered_checks(board, attacker)) {
+        // With one move left only an immediate mate will do, and the checks are sorted by evasion count
+        if (moves == 1 && !check.evasions.empty()) {
+            break;
+        }
+        if (defend(check, attacker, moves - 1)) {
+            best_move = check.move;
+            store(key, true, moves, best_move);
+            return true;
+        }
+        if (aborted) {
+            return false;
+        }
+    }
+
+    store(key, false, moves, Move());
+    return false;
+}
+
+bool MateSearch::defend(const Check& check, Color attacker, int moves) {
+    if (check.evasions.empty()) {
+        return true;
+    }
+    if (moves == 0) {
+        return false;
+    }
+
+    Color defender = (attacker == WHITE) ? BLACK : WHITE;
+    for (const Move& evasion : check.evasions) {
+        Board position = check.position;
+        position.update_move(evasion, defender);
+        Move reply;
+        if (!attack(position, attacker, moves, reply)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int MateSearch::shortest_mate(Board& board, Color attacker, int max_moves) {
+    for (int moves = 1; moves <= max_moves; moves++) {
+        Move move;
+        if (attack(board, attacker, moves, move)) {
+            return moves;
+        }
+    }
+    return max_moves;
+}
+
+MateResult MateSearch::search(Board& board, Color attacker, int max_moves) {
+    limits.start_clock();
+    nodes = 0;
+    aborted = false;
+    max_moves = std::min(max_moves, 255);
+
+    MateResult result{false, 0, {}, 0, 0.0, false};
+    Color defender = (attacker == WHITE) ? BLACK : WHITE;
+
+    // Deepen one move at a time so the first mate proven is the shortest
+    for (int moves = 1; moves <= max_moves && !aborted; moves++) {
+        Move move;
+        if (!attack(board, attacker, moves, move)) {
+            continue;
+        }
+        result.found = true;
+        result.moves = moves;
+
+        // Walk the proof: the attacker's proving check, then the evasion that holds out longest
+        Board position = board;
+        int remaining = moves;
+        while (attack(position, attacker, remaining, move)) {
+            result.line.push_back(move);
+            position.update_move(move, attacker);
+
+            std::vector<Move> evasions = position.get_legal_moves(defender);
+            if (evasions.empty()) {
+                break;
+            }
+            int longest = 0;
+            Move best_evasion;
+            for (Move& evasion : evasions) {
+                Board next = position.inspect_move(evasion, defender);
+                int length = shortest_mate(next, attacker, remaining - 1);
+                if (length > longest) {
+                    longest = length;
+                    best_evasion = evasion;
+                }
+            }
+            result.line.push_back(best_evasion);
+            position.update_move(best_evasion, defender);
+            remaining = longest;
+        }
+        break;
+    }
+
+    result.nodes = nodes;
+    result.seconds = limits.elapsed_seconds();
+    result.aborted = aborted && !result.found;
+    return result;
+}
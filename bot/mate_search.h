@@ -0,0 +1,70 @@
+#ifndef BOT_MATE_SEARCH_H
+#define BOT_MATE_SEARCH_H
+#include "../chess/board.h"
+#include "../chess/game.h"
+#include "../chess/move.h"
+#include "search_limits.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct MateResult {
+    bool found;
+    int moves;                  // mate in 'moves' attacker moves (0 when not found)
+    std::vector<Move> line;     // attacker move, best defence, ..., mating move
+    uint64_t nodes;
+    double seconds;
+    bool aborted;               // time or node limit hit before the search could finish
+};
+
+// Mate finder for puzzle verification: a depth-first proof search where the attacker only plays checks and the
+// defender plays every evasion, so no position is ever evaluated. Mates are tried for 1, 2, ... moves, so the
+// first one found is the shortest (among checking mates; quiet-move mates are out of scope).
+class MateSearch {
+private:
+    // Proven and disproven move counts of one position for the current attacker (0 = unknown)
+    struct MateEntry {
+        uint64_t key;
+        uint16_t move;      // proving attacker move, see pack_tt_move
+        uint8_t proven;     // attacker mates within this many moves
+        uint8_t disproven;  // no checking mate within this many moves
+    };
+
+    // A checking move with the position it leads to and the defender's replies there
+    struct Check {
+        Move move;
+        Board position;
+        std::vector<Move> evasions;
+    };
+
+    std::vector<MateEntry> entries;
+    size_t mask;
+
+    SearchLimits limits;
+    uint64_t nodes;
+    bool aborted;
+
+    MateEntry* probe(uint64_t key);
+    void store(uint64_t key, bool proven, int moves, const Move& move);
+    bool limits_exceeded();
+
+    // Whether 'attacker' to move mates within 'moves' moves, with 'best_move' the proving check
+    bool attack(Board& board, Color attacker, int moves, Move& best_move);
+    // Whether every evasion after 'check' loses within 'moves' further attacker moves
+    bool defend(const Check& check, Color attacker, int moves);
+
+    // Every checking move, fewest evasions first (a cheap proof-number style ordering)
+    std::vector<Check> ordered_checks(Board& board, Color attacker);
+    // Fewest attacker moves that still mate from this (proven) position
+    int shortest_mate(Board& board, Color attacker, int max_moves);
+
+public:
+    MateSearch(size_t megabytes = 16);
+
+    void set_search_limits(double seconds, uint64_t node_limit);
+
+    MateResult search(Board& board, Color attacker, int max_moves);
+};
+
+#endif
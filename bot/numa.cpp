@@ -0,0 +1,168 @@
+#include "numa.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// From linux/mempolicy.h, so there's no dependency on libnuma
+static const int MPOL_INTERLEAVE_MODE = 3;
+
+int NumaTopology::nodes() const {
+    return static_cast<int>(node_cpus.size());
+}
+
+int NumaTopology::cpus() const {
+    int count = 0;
+    for (const std::vector<int>& cpus : node_cpus) {
+        count += static_cast<int>(cpus.size());
+    }
+    return count;
+}
+
+std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            // Blank or malformed ranges (such as the trailing newline) are skipped
+        }
+    }
+    return cpus;
+}
+
+static bool read_line(const std::string& path, std::string& line) {
+    std::ifstream file(path);
+    return file && std::getline(file, line);
+}
+
+static NumaTopology read_topology() {
+    NumaTopology topology;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    std::string online;
+    if (read_line("/sys/devices/system/node/online", online)) {
+        for (int node : parse_cpu_list(online)) {
+            std::string list;
+            if (!read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", list)) {
+                continue;
+            }
+            std::vector<int> cpus;
+            for (int cpu : parse_cpu_list(list)) {
+                if (!have_mask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+                    cpus.push_back(cpu);
+                }
+            }
+            if (!cpus.empty()) {
+                topology.node_cpus.push_back(cpus);
+            }
+        }
+    }
+    if (topology.node_cpus.empty() && have_mask) {
+        // No NUMA information in sysfs: one node holding every CPU we may use
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+            }
+        }
+        topology.node_cpus.push_back(cpus);
+    }
+#endif
+    if (topology.node_cpus.empty()) {
+        std::vector<int> cpus(std::max(1u, std::thread::hardware_concurrency()));
+        for (size_t cpu = 0; cpu < cpus.size(); cpu++) {
+            cpus[cpu] = static_cast<int>(cpu);
+        }
+        topology.node_cpus.push_back(cpus);
+    }
+    return topology;
+}
+
+const NumaTopology& numa_topology() {
+    static const NumaTopology topology = read_topology();
+    return topology;
+}
+
+bool parse_thread_affinity(const std::string& text, ThreadAffinity& affinity) {
+    if (text == "none") {
+        affinity = AFFINITY_NONE;
+    } else if (text == "compact") {
+        affinity = AFFINITY_COMPACT;
+    } else if (text == "spread") {
+        affinity = AFFINITY_SPREAD;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int thread_cpu(int thread_index, ThreadAffinity affinity) {
+    const NumaTopology& topology = numa_topology();
+    if (affinity == AFFINITY_NONE || thread_index < 0) {
+        return -1;
+    }
+    if (affinity == AFFINITY_SPREAD) {
+        const std::vector<int>& cpus = topology.node_cpus[thread_index % topology.nodes()];
+        return cpus[(thread_index / topology.nodes()) % cpus.size()];
+    }
+    int index = thread_index % topology.cpus();
+    for (const std::vector<int>& cpus : topology.node_cpus) {
+        if (index < static_cast<int>(cpus.size())) {
+            return cpus[index];
+        }
+        index -= static_cast<int>(cpus.size());
+    }
+    return -1;
+}
+
+bool pin_current_thread(int thread_index, ThreadAffinity affinity) {
+    int cpu = thread_cpu(thread_index, affinity);
+#ifdef __linux__
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        // On Linux pid 0 means the calling thread, not the whole process
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+#endif
+    (void)cpu;
+    return false;
+}
+
+bool interleave_memory(void* memory, size_t bytes) {
+#if defined(__linux__) && defined(SYS_mbind)
+    std::string online;
+    if (numa_topology().nodes() < 2 || !read_line("/sys/devices/system/node/online", online)) {
+        return false;
+    }
+    const size_t bits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> node_mask(1, 0);
+    for (int node : parse_cpu_list(online)) {
+        node_mask.resize(std::max(node_mask.size(), node / bits + 1), 0);
+        node_mask[node / bits] |= 1UL << (node % bits);
+    }
+    // The kernel reads one bit less than 'maxnode'
+    return syscall(SYS_mbind, memory, bytes, MPOL_INTERLEAVE_MODE, node_mask.data(), node_mask.size() * bits + 1, 0) == 0;
+#else
+    (void)memory;
+    (void)bytes;
+    return false;
+#endif
+}
@@ -0,0 +1,42 @@
+#ifndef BOT_NUMA_H
+#define BOT_NUMA_H
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// NUMA topology and thread placement for the worker pools of datagen and match. The topology is read once from
+// /sys/devices/system/node and limited to the CPUs this process may run on. A machine without that directory, or
+// any system but Linux, looks like a single node: threads are still pinned there, and interleaving does nothing.
+
+enum ThreadAffinity {
+    AFFINITY_NONE,      // leave threads to the scheduler
+    AFFINITY_COMPACT,   // fill the CPUs of one node before moving on to the next
+    AFFINITY_SPREAD     // deal threads out to the nodes in turn
+};
+
+struct NumaTopology {
+    std::vector<std::vector<int>> node_cpus; // usable CPUs of each node, nodes without any left out
+
+    int nodes() const;
+    int cpus() const;
+};
+
+const NumaTopology& numa_topology();
+
+// Parses "none", "compact" or "spread"
+bool parse_thread_affinity(const std::string& text, ThreadAffinity& affinity);
+
+// CPUs in a sysfs list such as "0-3,8,10-11"
+std::vector<int> parse_cpu_list(const std::string& text);
+
+// The CPU the thread numbered 'thread_index' of a pool runs on, or -1 when it isn't pinned
+int thread_cpu(int thread_index, ThreadAffinity affinity);
+
+// Pins the calling thread to thread_cpu(thread_index, affinity). Returns whether it was pinned.
+bool pin_current_thread(int thread_index, ThreadAffinity affinity);
+
+// Spreads the pages of a page-aligned mapping round-robin over every node. Must be called before the memory is
+// first touched; returns false (leaving the default first-touch placement) when there is only one node.
+bool interleave_memory(void* memory, size_t bytes);
+
+#endif
@@ -0,0 +1,279 @@
+#include "opening_book.h"
+#include "../chess/game.h"
+#include "../chess/utils.h"
+#include "../chess/pgn.h"
+#include "../chess/notation.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Polyglot entries are 16 bytes, big-endian: key (8), move (2), weight (2), learn (4). Entries are sorted by key.
+static const size_t ENTRY_SIZE = 16;
+
+static uint64_t read_big_endian(const unsigned char* bytes, int num_bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < num_bytes; i++) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+OpeningBook::OpeningBook() : data(nullptr), num_entries(0), mapped_size(0) {}
+
+OpeningBook::OpeningBook(const std::string& path) : data(nullptr), num_entries(0), mapped_size(0) {
+    open(path);
+}
+
+OpeningBook::~OpeningBook() {
+    close();
+}
+
+bool OpeningBook::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t) ENTRY_SIZE) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        debug_log("Failed to map opening book " + path);
+        return false;
+    }
+
+    // Probes are binary searches, so tell the kernel not to bother reading ahead
+    madvise(mapping, file_stat.st_size, MADV_RANDOM);
+
+    data = static_cast<const unsigned char*>(mapping);
+    mapped_size = file_stat.st_size;
+    num_entries = mapped_size / ENTRY_SIZE;
+    return true;
+}
+
+void OpeningBook::close() {
+    if (data != nullptr) {
+        munmap(const_cast<unsigned char*>(data), mapped_size);
+    }
+    data = nullptr;
+    num_entries = 0;
+    mapped_size = 0;
+}
+
+bool OpeningBook::is_open() const {
+    return data != nullptr;
+}
+
+size_t OpeningBook::size() const {
+    return num_entries;
+}
+
+uint64_t OpeningBook::entry_key(size_t index) const {
+    return read_big_endian(data + index * ENTRY_SIZE, 8);
+}
+
+uint16_t OpeningBook::entry_move(size_t index) const {
+    return read_big_endian(data + index * ENTRY_SIZE + 8, 2);
+}
+
+uint16_t OpeningBook::entry_weight(size_t index) const {
+    return read_big_endian(data + index * ENTRY_SIZE + 10, 2);
+}
+
+bool OpeningBook::probe(Board& board, Color player, BookSelection selection, std::mt19937_64& rng, Move& move) const {
+    if (!is_open()) {
+        return false;
+    }
+
+    uint64_t key = board.get_hash(player);
+
+    // Binary search for the first entry with this key
+    size_t low = 0;
+    size_t high = num_entries;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (entry_key(mid) < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    // Collect every legal move stored for this key (skipping anything that doesn't fit the board, in case of collisions)
+    vector<Move> candidates;
+    vector<uint32_t> weights;
+    uint64_t total_weight = 0;
+    for (size_t i = low; i < num_entries && entry_key(i) == key; i++) {
+        Move candidate = decode_move(entry_move(i), board, player);
+        if (!board.is_legal_move(candidate, player)) {
+            continue;
+        }
+        candidates.push_back(candidate);
+        weights.push_back(entry_weight(i));
+        total_weight += entry_weight(i);
+    }
+
+    if (candidates.empty()) {
+        return false;
+    }
+
+    size_t chosen = 0;
+    if (selection == BOOK_WEIGHTED_RANDOM && total_weight > 0) {
+        uint64_t pick = std::uniform_int_distribution<uint64_t>(0, total_weight - 1)(rng);
+        while (pick >= weights[chosen]) {
+            pick -= weights[chosen];
+            chosen++;
+        }
+    } else {
+        for (size_t i = 1; i < candidates.size(); i++) {
+            if (weights[i] > weights[chosen]) {
+                chosen = i;
+            }
+        }
+    }
+
+    move = candidates[chosen];
+    return true;
+}
+
+// Polyglot move: bits 0-2 to file, 3-5 to rank, 6-8 from file, 9-11 from rank, 12-14 promotion (1=N, 2=B, 3=R, 4=Q).
+// Castling is stored as the king capturing its own rook (e1h1, e1a1, e8h8, e8a8).
+Move OpeningBook::decode_move(uint16_t book_move, Board& board, Color player) {
+    int dst_file = book_move & 7;
+    int dst_rank = (book_move >> 3) & 7;
+    int src_file = (book_move >> 6) & 7;
+    int src_rank = (book_move >> 9) & 7;
+    int promotion = (book_move >> 12) & 7;
+
+    Piece king = (player == WHITE) ? WHITE_KING : BLACK_KING;
+    int home_rank = (player == WHITE) ? 0 : 7;
+    if (board.get_piece(src_file, src_rank) == king && src_file == 4 && src_rank == home_rank && dst_rank == home_rank) {
+        if (dst_file == 7) {
+            return Move("oo");
+        }
+        if (dst_file == 0) {
+            return Move("ooo");
+        }
+    }
+
+    std::string notation;
+    notation.push_back('a' + src_file);
+    notation.push_back('1' + src_rank);
+    notation.push_back('a' + dst_file);
+    notation.push_back('1' + dst_rank);
+
+    const char promotion_pieces[] = {' ', 'N', 'B', 'R', 'Q'};
+    if (promotion >= 1 && promotion <= 4) {
+        notation += "p";
+        notation.push_back(promotion_pieces[promotion]);
+    }
+
+    return Move(notation);
+}
+
+uint16_t OpeningBook::encode_move(const Move& move, Board& board, Color player) {
+    std::string notation = move.get_move();
+    int home_rank = (player == WHITE) ? 0 : 7;
+
+    if (notation == "oo" || notation == "ooo") {
+        int rook_file = (notation == "oo") ? 7 : 0;
+        return rook_file | (home_rank << 3) | (4 << 6) | (home_rank << 9);
+    }
+
+    int src_file = notation[0] - 'a';
+    int src_rank = notation[1] - '1';
+    int dst_file = notation[2] - 'a';
+    int dst_rank = notation[3] - '1';
+    uint16_t book_move = dst_file | (dst_rank << 3) | (src_file << 6) | (src_rank << 9);
+
+    // Promotions (pawns reaching the back rank without a suffix promote to queens)
+    Piece piece = board.get_piece(src_file, src_rank);
+    if ((piece == WHITE_PAWN && dst_rank == 7) || (piece == BLACK_PAWN && dst_rank == 0)) {
+        int promotion = 4;
+        if (notation.length() == 6) {
+            switch (notation[5]) {
+                case 'N': promotion = 1; break;
+                case 'B': promotion = 2; break;
+                case 'R': promotion = 3; break;
+                default: promotion = 4; break;
+            }
+        }
+        book_move |= promotion << 12;
+    }
+
+    return book_move;
+}
+
+long build_opening_book(const std::string& pgn_path, const std::string& book_path, int max_plies) {
+    PgnReader reader(pgn_path);
+    if (!reader.is_open()) {
+        return -1;
+    }
+
+    std::map<std::pair<uint64_t, uint16_t>, uint64_t> weights;
+    PgnGame game;
+    while (reader.next(game)) {
+        if (game.result == "*") {
+            continue;
+        }
+
+        std::string fen = game.get_tag("FEN");
+        Board board = fen.empty() ? Board() : Board(fen);
+        Color player = (!fen.empty() && fen.find(" b ") != std::string::npos) ? BLACK : WHITE;
+        for (int ply = 0; ply < max_plies && ply < (int) game.moves.size(); ply++) {
+            Move move;
+            if (!san_to_move(board, game.moves[ply], player, move)) {
+                break;
+            }
+
+            bool won = (game.result == "1-0" && player == WHITE) || (game.result == "0-1" && player == BLACK);
+            int weight = won ? 2 : (game.result == "1/2-1/2" ? 1 : 0);
+            if (weight > 0) {
+                weights[{board.get_hash(player), OpeningBook::encode_move(move, board, player)}] += weight;
+            }
+
+            board.update_move(move, player);
+            player = (player == WHITE) ? BLACK : WHITE;
+        }
+    }
+
+    // Polyglot weights are 16 bits: scale everything down if the most played move doesn't fit
+    uint64_t max_weight = 0;
+    for (const auto& entry : weights) {
+        max_weight = std::max(max_weight, entry.second);
+    }
+    double scale = (max_weight > 0xFFFF) ? 65535.0 / max_weight : 1.0;
+
+    // The map is already in (key, move) order, which is the order probes binary-search in
+    std::ofstream out(book_path, std::ios::binary);
+    if (!out) {
+        return -1;
+    }
+    for (const auto& entry : weights) {
+        uint64_t key = entry.first.first;
+        uint16_t book_move = entry.first.second;
+        uint16_t weight = std::max<uint64_t>(1, entry.second * scale);
+        unsigned char bytes[ENTRY_SIZE] = {0};
+        for (int i = 0; i < 8; i++) {
+            bytes[i] = (key >> (56 - 8 * i)) & 0xFF;
+        }
+        bytes[8] = book_move >> 8;
+        bytes[9] = book_move & 0xFF;
+        bytes[10] = weight >> 8;
+        bytes[11] = weight & 0xFF;
+        out.write(reinterpret_cast<char*>(bytes), ENTRY_SIZE);
+    }
+    return out ? (long) weights.size() : -1;
+}
@@ -0,0 +1,52 @@
+#ifndef BOT_OPENING_BOOK_H
+#define BOT_OPENING_BOOK_H
+#include "../chess/board.h"
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <string>
+
+enum BookSelection : uint8_t {
+    BOOK_BEST_MOVE,         // always play the highest weighted move
+    BOOK_WEIGHTED_RANDOM    // pick randomly, proportional to weight
+};
+
+// Read-only Polyglot (.bin) opening book. The file is memory-mapped and binary-searched by position hash, so
+// a probe costs a handful of page touches no matter how large the book is.
+class OpeningBook {
+private:
+    const unsigned char* data;
+    size_t num_entries;
+    size_t mapped_size;
+
+    uint64_t entry_key(size_t index) const;
+    uint16_t entry_move(size_t index) const;
+    uint16_t entry_weight(size_t index) const;
+
+    static Move decode_move(uint16_t book_move, Board& board, Color player);
+
+public:
+    OpeningBook();
+    OpeningBook(const std::string& path);
+    ~OpeningBook();
+
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const;
+    size_t size() const;
+
+    // Returns true and sets 'move' if the book has a (legal) move for 'player' in this position.
+    bool probe(Board& board, Color player, BookSelection selection, std::mt19937_64& rng, Move& move) const;
+
+    static uint16_t encode_move(const Move& move, Board& board, Color player);
+};
+
+// Builds a Polyglot book from the first 'max_plies' plies of every game in a PGN file (streamed, so the database
+// can be any size). Moves get Polyglot's usual weight of 2 per win and 1 per draw for the side that played them;
+// moves that only ever lost are left out. Returns the number of entries written, or -1 on I/O failure.
+long build_opening_book(const std::string& pgn_path, const std::string& book_path, int max_plies);
+
+#endif
@@ -0,0 +1,18 @@
+#include "search_limits.h"
+
+void SearchLimits::start_clock() {
+    start = std::chrono::steady_clock::now();
+}
+
+double SearchLimits::elapsed_seconds() const {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+bool SearchLimits::exceeded(uint64_t nodes) const {
+    if (max_nodes > 0 && nodes >= max_nodes) {
+        return true;
+    }
+    // Checking the clock is comparatively slow, so only do it every 1024 nodes
+    return max_seconds > 0.0 && (nodes & 1023) == 0 && elapsed_seconds() >= max_seconds;
+}
@@ -0,0 +1,18 @@
+#ifndef BOT_SEARCH_LIMITS_H
+#define BOT_SEARCH_LIMITS_H
+#include <chrono>
+#include <cstdint>
+
+// Time and node budget of a search, shared by the main search and the mate finder.
+struct SearchLimits {
+    double max_seconds = 0.0; // 0 = no time limit
+    uint64_t max_nodes = 0;   // 0 = no node limit
+    std::chrono::steady_clock::time_point start;
+
+    void start_clock();
+    double elapsed_seconds() const;
+    // Whether a search that has visited 'nodes' nodes must stop
+    bool exceeded(uint64_t nodes) const;
+};
+
+#endif
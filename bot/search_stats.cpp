@@ -0,0 +1,98 @@
+#include "search_stats.h"
+#include <sstream>
+
+thread_local SearchCounters search_counters;
+
+void SearchCounters::reset() {
+    *this = SearchCounters();
+}
+
+void SearchCounters::merge(const SearchCounters& other) {
+    nodes += other.nodes;
+    qnodes += other.qnodes;
+    tt_probes += other.tt_probes;
+    tt_hits += other.tt_hits;
+    eval_probes += other.eval_probes;
+    eval_hits += other.eval_hits;
+    tb_hits += other.tb_hits;
+    interior_nodes += other.interior_nodes;
+    children_searched += other.children_searched;
+    cutoffs += other.cutoffs;
+    first_move_cutoffs += other.first_move_cutoffs;
+    futility_prunes += other.futility_prunes;
+    reverse_futility_prunes += other.reverse_futility_prunes;
+    razor_prunes += other.razor_prunes;
+    check_extensions += other.check_extensions;
+    recapture_extensions += other.recapture_extensions;
+    singular_extensions += other.singular_extensions;
+}
+
+void SearchStats::reset() {
+    totals.reset();
+    iterations.clear();
+    seconds = 0.0;
+}
+
+double SearchStats::nodes_per_second() const {
+    return seconds > 0.0 ? (totals.nodes + totals.qnodes) / seconds : 0.0;
+}
+
+double SearchStats::tt_hit_rate() const {
+    return totals.tt_probes > 0 ? (double) totals.tt_hits / totals.tt_probes : 0.0;
+}
+
+double SearchStats::eval_cache_hit_rate() const {
+    return totals.eval_probes > 0 ? (double) totals.eval_hits / totals.eval_probes : 0.0;
+}
+
+double SearchStats::first_move_cutoff_rate() const {
+    return totals.cutoffs > 0 ? (double) totals.first_move_cutoffs / totals.cutoffs : 0.0;
+}
+
+// Average number of children searched per expanded node (lower = better move ordering/pruning)
+double SearchStats::branching_factor() const {
+    return totals.interior_nodes > 0 ? (double) totals.children_searched / totals.interior_nodes : 0.0;
+}
+
+std::string SearchStats::to_json() const {
+    std::ostringstream out;
+    out << "{\"nodes\":" << totals.nodes
+        << ",\"qnodes\":" << totals.qnodes
+        << ",\"seconds\":" << seconds
+        << ",\"nps\":" << (uint64_t) nodes_per_second()
+        << ",\"tt_probes\":" << totals.tt_probes
+        << ",\"tt_hit_rate\":" << tt_hit_rate()
+        << ",\"eval_probes\":" << totals.eval_probes
+        << ",\"eval_cache_hit_rate\":" << eval_cache_hit_rate()
+        << ",\"tb_hits\":" << totals.tb_hits
+        << ",\"cutoffs\":" << totals.cutoffs
+        << ",\"first_move_cutoff_rate\":" << first_move_cutoff_rate()
+        << ",\"branching_factor\":" << branching_factor()
+        << ",\"futility_prunes\":" << totals.futility_prunes
+        << ",\"reverse_futility_prunes\":" << totals.reverse_futility_prunes
+        << ",\"razor_prunes\":" << totals.razor_prunes
+        << ",\"check_extensions\":" << totals.check_extensions
+        << ",\"recapture_extensions\":" << totals.recapture_extensions
+        << ",\"singular_extensions\":" << totals.singular_extensions
+        << ",\"iterations\":[";
+    for (size_t i = 0; i < iterations.size(); i++) {
+        const IterationStats& iteration = iterations[i];
+        out << (i > 0 ? "," : "")
+            << "{\"depth\":" << iteration.depth
+            << ",\"nodes\":" << iteration.nodes
+            << ",\"seconds\":" << iteration.seconds
+            << ",\"score\":" << iteration.score
+            << ",\"best_move\":\"" << iteration.best_move << "\""
+            << ",\"lines\":[";
+        for (size_t j = 0; j < iteration.lines.size(); j++) {
+            out << (j > 0 ? "," : "") << "{\"score\":" << iteration.lines[j].score << ",\"pv\":\"";
+            for (size_t k = 0; k < iteration.lines[j].moves.size(); k++) {
+                out << (k > 0 ? " " : "") << iteration.lines[j].moves[k];
+            }
+            out << "\"}";
+        }
+        out << "]}";
+    }
+    out << "]}";
+    return out.str();
+}
@@ -0,0 +1,75 @@
+#ifndef BOT_SEARCH_STATS_H
+#define BOT_SEARCH_STATS_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-thread search counters. Node counts are always kept (they're what bench and node limits run on); everything
+// else only costs anything when built with -DSEARCH_STATS (make STATS=1), otherwise STATS_INC compiles to nothing.
+struct SearchCounters {
+    uint64_t nodes = 0;              // positions visited by the main search
+    uint64_t qnodes = 0;             // positions visited by the quiescence search
+    uint64_t tt_probes = 0;
+    uint64_t tt_hits = 0;
+    uint64_t eval_probes = 0;        // static evaluations requested from the evaluation cache
+    uint64_t eval_hits = 0;
+    uint64_t tb_hits = 0;            // bitbase/tablebase probes that ended a line
+    uint64_t interior_nodes = 0;     // nodes that searched at least one child
+    uint64_t children_searched = 0;
+    uint64_t cutoffs = 0;
+    uint64_t first_move_cutoffs = 0; // cutoffs caused by the first move searched
+    uint64_t futility_prunes = 0;    // quiet moves skipped by futility pruning
+    uint64_t reverse_futility_prunes = 0;
+    uint64_t razor_prunes = 0;
+    uint64_t check_extensions = 0;
+    uint64_t recapture_extensions = 0;
+    uint64_t singular_extensions = 0;
+
+    void reset();
+    void merge(const SearchCounters& other);
+};
+
+extern thread_local SearchCounters search_counters;
+
+#ifdef SEARCH_STATS
+#define STATS_INC(counter) (search_counters.counter++)
+#define STATS_ADD(counter, amount) (search_counters.counter += (amount))
+#else
+#define STATS_INC(counter) ((void) 0)
+#define STATS_ADD(counter, amount) ((void) 0)
+#endif
+
+// One principal variation: the root move first, then the expected replies
+struct PvLine {
+    double score;
+    std::vector<std::string> moves;
+};
+
+struct IterationStats {
+    int depth;
+    uint64_t nodes;
+    double seconds;
+    double score;
+    std::string best_move;
+    std::vector<PvLine> lines; // best line first (more than one in multi-PV searches)
+};
+
+// Everything measured during one Bot::request_move, summed over all search threads.
+struct SearchStats {
+    SearchCounters totals;
+    std::vector<IterationStats> iterations;
+    double seconds = 0.0;
+
+    void reset();
+
+    double nodes_per_second() const;
+    double tt_hit_rate() const;
+    double eval_cache_hit_rate() const;
+    double first_move_cutoff_rate() const;
+    double branching_factor() const;
+
+    // One line of JSON, for logs and scripts
+    std::string to_json() const;
+};
+
+#endif
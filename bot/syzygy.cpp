@@ -0,0 +1,174 @@
+#include "syzygy.h"
+#include "../chess/game.h"
+#include "../chess/utils.h"
+
+#ifdef USE_SYZYGY
+#include "tbprobe.h"
+#endif
+
+#ifdef USE_SYZYGY
+
+static const double SYZYGY_WIN_SCORE = 40000.0;
+
+// Fathom wants one bitboard per color and per piece type (A1 = bit 0, same layout as Board)
+struct SyzygyPosition {
+    uint64_t white = 0, black = 0;
+    uint64_t kings = 0, queens = 0, rooks = 0, bishops = 0, knights = 0, pawns = 0;
+    int num_pieces = 0;
+};
+
+static bool load_syzygy_position(Board& board, SyzygyPosition& position) {
+    for (int index = 0; index < 64; index++) {
+        Piece piece = board.get_piece(index % 8, index / 8);
+        if (piece == EMPTY) {
+            continue;
+        }
+
+        if (++position.num_pieces > (int) TB_LARGEST) {
+            return false;
+        }
+
+        uint64_t bit = 1ULL << index;
+        if (piece >= WHITE_PAWN && piece <= WHITE_KING) {
+            position.white |= bit;
+        } else {
+            position.black |= bit;
+        }
+
+        switch (piece) {
+            case WHITE_PAWN:   case BLACK_PAWN:   position.pawns |= bit; break;
+            case WHITE_KNIGHT: case BLACK_KNIGHT: position.knights |= bit; break;
+            case WHITE_BISHOP: case BLACK_BISHOP: position.bishops |= bit; break;
+            case WHITE_ROOK:   case BLACK_ROOK:   position.rooks |= bit; break;
+            case WHITE_QUEEN:  case BLACK_QUEEN:  position.queens |= bit; break;
+            case WHITE_KING:   case BLACK_KING:   position.kings |= bit; break;
+            default: break;
+        }
+    }
+    return true;
+}
+
+bool init_syzygy(const std::string& path) {
+    if (!tb_init(path.c_str()) || TB_LARGEST == 0) {
+        debug_log("No Syzygy tablebases found in " + path);
+        return false;
+    }
+    debug_log("Loaded " + std::to_string(TB_LARGEST) + "-piece Syzygy tablebases from " + path);
+    return true;
+}
+
+int syzygy_max_pieces() {
+    return TB_LARGEST;
+}
+
+bool probe_syzygy_score(Board& board, Color player_to_move, int depth, double& score) {
+    if (TB_LARGEST == 0 || board.get_draw_move_counter() != 0 || board.has_castling_rights()) {
+        return false;
+    }
+
+    SyzygyPosition position;
+    if (!load_syzygy_position(board, position)) {
+        return false;
+    }
+
+    int ep_square = board.get_en_passant_square();
+    unsigned wdl = tb_probe_wdl(position.white, position.black, position.kings, position.queens, position.rooks,
+                                position.bishops, position.knights, position.pawns, 0, 0,
+                                ep_square == -1 ? 0 : ep_square, player_to_move == WHITE);
+    if (wdl == TB_RESULT_FAILED) {
+        return false;
+    }
+
+    // Prefer the shortest route to a win (and the longest way to lose)
+    double side_score = 0.0;
+    if (wdl == TB_WIN) {
+        side_score = SYZYGY_WIN_SCORE - depth;
+    } else if (wdl == TB_LOSS) {
+        side_score = -SYZYGY_WIN_SCORE + depth;
+    }
+
+    score = (player_to_move == WHITE) ? side_score : -side_score;
+    return true;
+}
+
+bool filter_syzygy_root_moves(Board& board, Color player, vector<Move>& moves) {
+    if (TB_LARGEST == 0 || board.has_castling_rights()) {
+        return false;
+    }
+
+    SyzygyPosition position;
+    if (!load_syzygy_position(board, position)) {
+        return false;
+    }
+
+    unsigned results[TB_MAX_MOVES];
+    int ep_square = board.get_en_passant_square();
+    unsigned best = tb_probe_root(position.white, position.black, position.kings, position.queens, position.rooks,
+                                  position.bishops, position.knights, position.pawns, board.get_draw_move_counter(), 0,
+                                  ep_square == -1 ? 0 : ep_square, player == WHITE, results);
+    if (best == TB_RESULT_FAILED || best == TB_RESULT_CHECKMATE || best == TB_RESULT_STALEMATE) {
+        return false;
+    }
+
+    // Best WDL over all root moves, then the quickest zeroing move among the wins
+    unsigned best_wdl = TB_GET_WDL(best);
+    unsigned best_dtz = ~0u;
+    for (int i = 0; results[i] != TB_RESULT_FAILED; i++) {
+        if (TB_GET_WDL(results[i]) == best_wdl && TB_GET_DTZ(results[i]) < best_dtz) {
+            best_dtz = TB_GET_DTZ(results[i]);
+        }
+    }
+
+    const std::string promotion_suffixes[] = {"", "", "pR", "pB", "pN"}; // TB_PROMOTES_NONE, QUEEN, ROOK, BISHOP, KNIGHT
+    vector<Move> kept;
+    for (int i = 0; results[i] != TB_RESULT_FAILED; i++) {
+        if (TB_GET_WDL(results[i]) != best_wdl) {
+            continue;
+        }
+        if (best_wdl == TB_WIN && TB_GET_DTZ(results[i]) != best_dtz) {
+            continue;
+        }
+
+        int src = TB_GET_FROM(results[i]);
+        int dst = TB_GET_TO(results[i]);
+        std::string notation;
+        notation.push_back('a' + src % 8);
+        notation.push_back('1' + src / 8);
+        notation.push_back('a' + dst % 8);
+        notation.push_back('1' + dst / 8);
+        notation += promotion_suffixes[TB_GET_PROMOTES(results[i])];
+
+        for (const Move& move : moves) {
+            if (move.get_move() == notation) {
+                kept.push_back(move);
+            }
+        }
+    }
+
+    if (kept.empty()) {
+        return false;
+    }
+    moves = kept;
+    return true;
+}
+
+#else
+
+bool init_syzygy(const std::string& path) {
+    debug_log("Built without Syzygy support, ignoring tablebase path " + path);
+    return false;
+}
+
+int syzygy_max_pieces() {
+    return 0;
+}
+
+bool probe_syzygy_score(Board&, Color, int, double&) {
+    return false;
+}
+
+bool filter_syzygy_root_moves(Board&, Color, vector<Move>&) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef BOT_SYZYGY_H
+#define BOT_SYZYGY_H
+#include "../chess/board.h"
+#include <string>
+
+// Optional Syzygy tablebase probing. Only available when built with `make SYZYGY=1 FATHOM=<path to Fathom/src>`;
+// otherwise every function here reports that no tablebases are loaded and the engine runs as usual.
+
+// Loads (memory-maps) the tablebase files found in 'path'. Returns false if none could be loaded.
+bool init_syzygy(const std::string& path);
+
+// Largest number of pieces (kings included) covered by the loaded tablebases, 0 if none are loaded.
+int syzygy_max_pieces();
+
+// White-relative score for the search: 0 for draws (including wins/losses spoiled by the fifty move rule), a large
+// score for wins. Only succeeds right after a capture or pawn move, since the WDL tables assume a fresh 50-move count.
+bool probe_syzygy_score(Board& board, Color player_to_move, int depth, double& score);
+
+// Removes root moves that don't keep the best tablebase result (and, when winning, aren't the fastest conversion).
+// Leaves 'moves' untouched if the position isn't in the tablebases.
+bool filter_syzygy_root_moves(Board& board, Color player, vector<Move>& moves);
+
+#endif
@@ -0,0 +1,233 @@
+#include "transposition_table.h"
+#include "numa.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+
+static const double MATE_BOUND = 900000;
+
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+static uint8_t pack_bound_generation(TTBound bound, uint8_t generation) {
+    return static_cast<uint8_t>(bound | (generation << 2));
+}
+
+static TTBound slot_bound(uint8_t bound_generation) {
+    return static_cast<TTBound>(bound_generation & 3);
+}
+
+static uint8_t slot_generation(uint8_t bound_generation) {
+    return bound_generation >> 2;
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes, TTPlacement placement)
+        : buckets(nullptr), mask(0), mapped_bytes(0), huge_pages(false), placement(placement), generation(0) {
+    resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable() {
+    release();
+}
+
+TranspositionTable::TranspositionTable(TranspositionTable&& other) noexcept
+        : buckets(other.buckets), mask(other.mask), mapped_bytes(other.mapped_bytes), huge_pages(other.huge_pages),
+          placement(other.placement), generation(other.generation) {
+    other.buckets = nullptr;
+    other.mapped_bytes = 0;
+}
+
+TranspositionTable& TranspositionTable::operator=(TranspositionTable&& other) noexcept {
+    if (this != &other) {
+        release();
+        buckets = other.buckets;
+        mask = other.mask;
+        mapped_bytes = other.mapped_bytes;
+        huge_pages = other.huge_pages;
+        placement = other.placement;
+        generation = other.generation;
+        other.buckets = nullptr;
+        other.mapped_bytes = 0;
+    }
+    return *this;
+}
+
+void TranspositionTable::release() {
+    if (buckets != nullptr) {
+        munmap(buckets, mapped_bytes);
+        buckets = nullptr;
+    }
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    size_t count = power_of_two_entries(megabytes, sizeof(TTBucket));
+    release();
+    mask = count - 1;
+
+    // Whole huge pages, so the kernel can back all of the table with them. Anonymous mappings start zeroed
+    // (all slots empty) and are page aligned, so buckets never straddle a cache line.
+    size_t bytes = count * sizeof(TTBucket);
+    mapped_bytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void* memory = MAP_FAILED;
+    huge_pages = false;
+#ifdef MAP_HUGETLB
+    memory = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    huge_pages = memory != MAP_FAILED;
+#endif
+    if (memory == MAP_FAILED) {
+        memory = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        huge_pages = madvise(memory, mapped_bytes, MADV_HUGEPAGE) == 0;
+#endif
+    }
+    // Nothing has touched the pages yet, so the policy decides where every one of them is allocated
+    if (placement == TT_INTERLEAVED) {
+        interleave_memory(memory, mapped_bytes);
+    }
+    buckets = static_cast<TTBucket*>(memory);
+}
+
+void TranspositionTable::set_placement(TTPlacement new_placement) {
+    placement = new_placement;
+    resize((mask + 1) * sizeof(TTBucket) / (1024 * 1024));
+}
+
+void TranspositionTable::clear() {
+    std::memset(static_cast<void*>(buckets), 0, (mask + 1) * sizeof(TTBucket));
+    generation = 0;
+}
+
+void TranspositionTable::new_search() {
+    // Generations are stored in 6 bits
+    generation = (generation + 1) & 63;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    const TTBucket& bucket = buckets[key & mask];
+    uint32_t check = static_cast<uint32_t>(key >> 32);
+    for (const TTSlot& slot : bucket.slots) {
+        TTBound bound = slot_bound(slot.bound_generation);
+        if (bound != TT_NONE && slot.key == check) {
+            entry = TTEntry{key, slot.score, slot.move, slot.depth, bound, slot_generation(slot.bound_generation)};
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, double score, TTBound bound, int depth, const Move& move) {
+    TTBucket& bucket = buckets[key & mask];
+    uint32_t check = static_cast<uint32_t>(key >> 32);
+
+    // The same position is always refreshed. Otherwise an empty slot is used, then the shallowest slot left by an
+    // older search, then the shallowest one from this search.
+    TTSlot* target = nullptr;
+    int target_priority = 0;
+    for (TTSlot& slot : bucket.slots) {
+        TTBound slot_bound_value = slot_bound(slot.bound_generation);
+        if (slot_bound_value != TT_NONE && slot.key == check) {
+            target = &slot;
+            break;
+        }
+        int priority;
+        if (slot_bound_value == TT_NONE) {
+            priority = -1000;
+        } else {
+            bool current = slot_generation(slot.bound_generation) == generation;
+            priority = slot.depth + (current ? 256 : 0);
+        }
+        if (target == nullptr || priority < target_priority) {
+            target = &slot;
+            target_priority = priority;
+        }
+    }
+
+    // Don't lose a known best move to a result that has none
+    uint16_t packed_move = pack_tt_move(move);
+    bool same_position = slot_bound(target->bound_generation) != TT_NONE && target->key == check;
+    if (packed_move == 0 && same_position) {
+        packed_move = target->move;
+    }
+
+    *target = TTSlot{score, check, packed_move, static_cast<int8_t>(std::min(depth, 127)),
+                     pack_bound_generation(bound, generation)};
+}
+
+int TranspositionTable::hashfull() const {
+    size_t sample = std::min<size_t>(1000 / BUCKET_SLOTS, mask + 1);
+    int used = 0;
+    for (size_t i = 0; i < sample; i++) {
+        for (const TTSlot& slot : buckets[i].slots) {
+            if (slot_bound(slot.bound_generation) != TT_NONE && slot_generation(slot.bound_generation) == generation) {
+                used++;
+            }
+        }
+    }
+    return used * 1000 / (sample * BUCKET_SLOTS);
+}
+
+bool TranspositionTable::uses_huge_pages() const {
+    return huge_pages;
+}
+
+TTPlacement TranspositionTable::get_placement() const {
+    return placement;
+}
+
+size_t power_of_two_entries(size_t megabytes, size_t entry_size) {
+    size_t count = 1;
+    while (count * 2 * entry_size <= std::max<size_t>(megabytes, 1) * 1024 * 1024) {
+        count *= 2;
+    }
+    return count;
+}
+
+double score_to_tt(double score, int ply) {
+    if (score > MATE_BOUND) { return score + ply; }
+    if (score < -MATE_BOUND) { return score - ply; }
+    return score;
+}
+
+double score_from_tt(double score, int ply) {
+    if (score > MATE_BOUND) { return score - ply; }
+    if (score < -MATE_BOUND) { return score + ply; }
+    return score;
+}
+
+uint16_t pack_tt_move(const Move& move) {
+    std::string notation = move.get_move();
+    if (notation == "oo") { return 1 << 14; }
+    if (notation == "ooo") { return 1 << 15; }
+    if (notation.size() < 4) { return 0; }
+
+    int src = (notation[1] - '1') * 8 + (notation[0] - 'a');
+    int dst = (notation[3] - '1') * 8 + (notation[2] - 'a');
+    int promotion = 0;
+    if (notation.size() > 5) {
+        promotion = (notation[5] == 'R') ? 1 : (notation[5] == 'N') ? 2 : 3;
+    }
+    return src | (dst << 6) | (promotion << 12);
+}
+
+Move unpack_tt_move(uint16_t move) {
+    if (move == 0) { return Move(); }
+    if (move & (1 << 14)) { return Move("oo"); }
+    if (move & (1 << 15)) { return Move("ooo"); }
+
+    int src = move & 63;
+    int dst = (move >> 6) & 63;
+    int promotion = (move >> 12) & 3;
+    std::string notation;
+    notation += static_cast<char>('a' + src % 8);
+    notation += static_cast<char>('1' + src / 8);
+    notation += static_cast<char>('a' + dst % 8);
+    notation += static_cast<char>('1' + dst / 8);
+    if (promotion != 0) {
+        notation += std::string("p") + "RNB"[promotion - 1];
+    }
+    return Move(notation);
+}
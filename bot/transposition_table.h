@@ -0,0 +1,103 @@
+#ifndef BOT_TRANSPOSITION_TABLE_H
+#define BOT_TRANSPOSITION_TABLE_H
+#include "../chess/move.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Scores are white-relative like the rest of the search, so a bound says which side of the true score the
+// stored one is on, whoever was to move.
+enum TTBound : uint8_t {
+    TT_NONE,
+    TT_EXACT,
+    TT_LOWER,   // true score >= stored score
+    TT_UPPER    // true score <= stored score
+};
+
+struct TTEntry {
+    uint64_t key;
+    double score;
+    uint16_t move;      // see pack_tt_move
+    int8_t depth;       // plies searched below this position
+    TTBound bound;
+    uint8_t generation;
+};
+
+enum TTPlacement {
+    TT_NODE_LOCAL,  // pages land on the node of the thread that first touches them (the kernel's default)
+    TT_INTERLEAVED  // pages are spread round-robin over every NUMA node
+};
+
+// The table is an array of 64-byte buckets, one cache line each, so a probe touches a single line. A position can
+// be stored in any slot of the bucket its key indexes; slots keep the upper half of the key to tell positions apart.
+// The memory comes from 2 MB huge pages where the system has them (explicit MAP_HUGETLB pages, then transparent
+// huge pages through madvise), which keeps random probes from missing the TLB as well as the cache. A table probed
+// from one pinned thread is best left node-local; one shared by threads on several nodes can be interleaved instead.
+class TranspositionTable {
+private:
+    struct TTSlot {
+        double score;
+        uint32_t key;       // upper 32 bits of the key (the lower bits pick the bucket)
+        uint16_t move;
+        int8_t depth;
+        uint8_t bound_generation; // bound in the low 2 bits, generation in the upper 6
+    };
+    static const int BUCKET_SLOTS = 4;
+    struct alignas(64) TTBucket {
+        TTSlot slots[BUCKET_SLOTS];
+    };
+
+    TTBucket* buckets;
+    size_t mask;
+    size_t mapped_bytes;
+    bool huge_pages;
+    TTPlacement placement;
+    uint8_t generation;
+
+    void release();
+
+public:
+    TranspositionTable(size_t megabytes, TTPlacement placement = TT_NODE_LOCAL);
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+    TranspositionTable(TranspositionTable&& other) noexcept;
+    TranspositionTable& operator=(TranspositionTable&& other) noexcept;
+
+    void resize(size_t megabytes);
+    // Remaps the table (clearing it) with the new placement
+    void set_placement(TTPlacement new_placement);
+    void clear();
+
+    // Called once per search: entries from older searches are replaced first
+    void new_search();
+
+    // Start loading the bucket of 'key' into the cache, ahead of a probe or store of it
+    void prefetch(uint64_t key) const {
+        __builtin_prefetch(&buckets[key & mask]);
+    }
+
+    bool probe(uint64_t key, TTEntry& entry) const;
+    void store(uint64_t key, double score, TTBound bound, int depth, const Move& move);
+
+    // Permille of sampled slots used by the current search
+    int hashfull() const;
+    // Whether the table got explicit 2 MB pages, or transparent huge pages were requested for it
+    bool uses_huge_pages() const;
+    TTPlacement get_placement() const;
+};
+
+// Mate scores are stored relative to the position ('ply' = its distance from the root), so they stay correct
+// when the same position is reached at a different ply.
+double score_to_tt(double score, int ply);
+double score_from_tt(double score, int ply);
+
+// 16-bit move codes: bits 0-5 source, 6-11 destination, 12-13 under-promotion (1=R, 2=N, 3=B), 14/15 castling
+uint16_t pack_tt_move(const Move& move);
+Move unpack_tt_move(uint16_t move);
+
+// The number of 'entry_size' entries that fit in 'megabytes' (at least 1 MB), rounded down to a power of two so a
+// hash table's index is a mask. Shared by the transposition table, evaluation cache and mate search table.
+size_t power_of_two_entries(size_t megabytes, size_t entry_size);
+
+#endif
@@ -0,0 +1,254 @@
+#include "tuner.h"
+#include "driver.h"
+#include "../chess/board.h"
+#include "../chess/epd.h"
+#include "../chess/packed_position.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <thread>
+using std::cout, std::endl;
+
+// Reduces a labelled position to its quiet leaf; false for mates and stalemates, which tell the tuner nothing
+// about the evaluation.
+static bool resolve_position(Bot& bot, Board& board, Color side_to_move, double result, TuningPosition& position) {
+    if (board.get_terminal_state(side_to_move) != NOT_TERMINAL) {
+        return false;
+    }
+
+    Board leaf;
+    bot.quiescence(board, side_to_move, -std::numeric_limits<double>::infinity(),
+                   std::numeric_limits<double>::infinity(), &leaf);
+    position = {leaf.get_eval_features(), result};
+    return true;
+}
+
+// Runs 'resolve(bot, index, position)' for every index in [0, count) split over 'threads', keeping the successes
+template <typename Resolve>
+static std::vector<TuningPosition> resolve_in_parallel(size_t count, const EvalParams& params, int threads, Resolve resolve) {
+    std::vector<TuningPosition> positions(count);
+    std::vector<char> valid(count, 0);
+    auto worker = [&](size_t begin, size_t end) {
+        Bot bot(1);
+        bot.set_eval_params(params);
+        for (size_t i = begin; i < end; i++) {
+            valid[i] = resolve(bot, i, positions[i]);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    size_t chunk = (count + threads - 1) / threads;
+    for (int t = 0; t < threads; t++) {
+        size_t begin = std::min(count, t * chunk);
+        size_t end = std::min(count, begin + chunk);
+        workers.emplace_back(worker, begin, end);
+    }
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (valid[i]) {
+            positions[kept++] = positions[i];
+        }
+    }
+    positions.resize(kept);
+    return positions;
+}
+
+// Loads the dataset (packed .bin records, or text lines) and resolves every position to its quiet leaf.
+static std::vector<TuningPosition> load_tuning_positions(const std::string& path, const EvalParams& params, int threads) {
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0) {
+        PackedPositionFile file(path);
+        if (!file.is_open()) {
+            return {};
+        }
+        return resolve_in_parallel(file.size(), params, threads, [&](Bot& bot, size_t i, TuningPosition& position) {
+            if (file[i].result == PACKED_NO_RESULT) {
+                return false;
+            }
+            Color side_to_move;
+            Board board = file.board(i, side_to_move);
+            return resolve_position(bot, board, side_to_move, file[i].result / 2.0, position);
+        });
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return {};
+    }
+
+    // Text sets can run to gigabytes, so only one chunk of lines is held in memory at a time
+    static const size_t LINES_PER_CHUNK = 1 << 16;
+    std::vector<TuningPosition> positions;
+    std::vector<std::string> lines;
+    std::string line;
+    while (true) {
+        lines.clear();
+        while (lines.size() < LINES_PER_CHUNK && std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        if (lines.empty()) {
+            break;
+        }
+        std::vector<TuningPosition> chunk = resolve_in_parallel(lines.size(), params, threads,
+                                                                [&](Bot& bot, size_t i, TuningPosition& position) {
+            std::string fen;
+            Color side_to_move;
+            double result;
+            if (!parse_labelled_position(lines[i], fen, side_to_move, result)) {
+                return false;
+            }
+            Board board(fen);
+            return resolve_position(bot, board, side_to_move, result, position);
+        });
+        positions.insert(positions.end(), chunk.begin(), chunk.end());
+    }
+    return positions;
+}
+
+double tuning_error(const std::vector<TuningPosition>& positions, const EvalParams& params, double k, int threads) {
+    if (positions.empty()) {
+        return 0.0;
+    }
+
+    threads = std::max(1, std::min<int>(threads, positions.size()));
+    std::vector<double> sums(threads, 0.0);
+    auto worker = [&](int t) {
+        size_t begin = positions.size() * t / threads;
+        size_t end = positions.size() * (t + 1) / threads;
+        double sum = 0.0;
+        for (size_t i = begin; i < end; i++) {
+            double eval = evaluate_features(positions[i].features, params);
+            double predicted = 1.0 / (1.0 + std::pow(10.0, -k * eval / 400.0));
+            double difference = positions[i].result - predicted;
+            sum += difference * difference;
+        }
+        sums[t] = sum;
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+
+    double total = 0.0;
+    for (double sum : sums) {
+        total += sum;
+    }
+    return total / positions.size();
+}
+
+// Scaling constant K that best maps the starting evaluation to results (coarse-to-fine scan)
+static double fit_k(const std::vector<TuningPosition>& positions, const EvalParams& params, int threads) {
+    double best_k = 1.0;
+    double best_error = tuning_error(positions, params, best_k, threads);
+    double step = 1.0;
+    for (int round = 0; round < 5; round++) {
+        double center = best_k;
+        for (int i = -10; i <= 10; i++) {
+            double k = center + i * step;
+            if (k <= 0.0) {
+                continue;
+            }
+            double error = tuning_error(positions, params, k, threads);
+            if (error < best_error) {
+                best_error = error;
+                best_k = k;
+            }
+        }
+        step /= 10.0;
+    }
+    return best_k;
+}
+
+void run_tuner(const std::vector<std::string>& args) {
+    std::map<std::string, std::string> options;
+    for (const std::string& arg : args) {
+        size_t equals = arg.find('=');
+        if (equals == std::string::npos) {
+            std::cerr << "Ignoring tuner argument '" << arg << "' (expected key=value)" << endl;
+            continue;
+        }
+        options[arg.substr(0, equals)] = arg.substr(equals + 1);
+    }
+    if (!options.count("data")) {
+        std::cerr << "tune: data=<file> is required" << endl;
+        return;
+    }
+    std::string out = options.count("out") ? options["out"] : "eval.params";
+    unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    int threads = options.count("threads") ? std::max(1, std::stoi(options["threads"])) : hardware_threads;
+    int epochs = options.count("epochs") ? std::stoi(options["epochs"]) : 100;
+
+    EvalParams params;
+    if (options.count("params") && !load_eval_params(options["params"], params)) {
+        std::cerr << "Could not load parameters from " << options["params"] << endl;
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<TuningPosition> positions = load_tuning_positions(options["data"], params, threads);
+    std::chrono::duration<double> load_time = std::chrono::steady_clock::now() - start;
+    if (positions.empty()) {
+        std::cerr << "No labelled positions in " << options["data"] << endl;
+        return;
+    }
+    cout << "Loaded " << positions.size() << " positions in " << load_time.count() << " s" << endl;
+
+    double k = fit_k(positions, params, threads);
+    double best_error = tuning_error(positions, params, k, threads);
+    cout << "K = " << k << ", starting error " << best_error << endl;
+
+    // Local search: nudge each parameter up or down while that lowers the error, and halve a parameter's step
+    // once neither direction helps
+    const std::vector<EvalParamField>& fields = eval_param_fields();
+    std::vector<double> steps;
+    for (const EvalParamField& field : fields) {
+        steps.push_back(0.1 * std::max(1.0, std::abs(params.*field.value)));
+    }
+
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        bool improved = false;
+        for (size_t i = 0; i < fields.size(); i++) {
+            double& value = params.*fields[i].value;
+            double original = value;
+            bool param_improved = false;
+            for (double direction : {1.0, -1.0}) {
+                value = original + direction * steps[i];
+                double error = tuning_error(positions, params, k, threads);
+                if (error < best_error) {
+                    best_error = error;
+                    param_improved = true;
+                    break;
+                }
+            }
+            if (!param_improved) {
+                value = original;
+                steps[i] /= 2.0;
+            }
+            improved = improved || param_improved;
+        }
+
+        save_eval_params(out, params);
+        char line[96];
+        std::snprintf(line, sizeof(line), "Epoch %d: error %.8f", epoch, best_error);
+        cout << line << endl;
+
+        if (!improved && *std::max_element(steps.begin(), steps.end()) < 1e-4) {
+            break;
+        }
+    }
+
+    cout << "Wrote " << out << endl;
+}
@@ -0,0 +1,25 @@
+#ifndef BOT_TUNER_H
+#define BOT_TUNER_H
+#include "../chess/eval_params.h"
+#include <string>
+#include <vector>
+
+// Texel tuning: finds the EvalParams whose evaluation best predicts game results, by minimizing
+//   E = mean((result - sigmoid(K * eval))^2),  sigmoid(x) = 1 / (1 + 10^(-x / 400))
+// over a set of labelled positions. Arguments are key=value pairs:
+//   data=<file>    packed positions (.bin, see chess/packed_position.h), or one position per line:
+//                  "<FEN> [1.0]", "<FEN> [0.5]", "<EPD> c9 \"1-0\";", "<FEN> 0-1", ...
+//   out=<file>     parameter file written after every epoch (default eval.params)
+//   params=<file>  starting parameters (default: the built-in ones)
+//   threads=<n>  epochs=<n>
+void run_tuner(const std::vector<std::string>& args);
+
+// A labelled position reduced to its quiet (quiescence) leaf, which is all the error needs.
+struct TuningPosition {
+    EvalFeatures features;
+    double result; // 1 white won, 0.5 draw, 0 black won
+};
+
+double tuning_error(const std::vector<TuningPosition>& positions, const EvalParams& params, double k, int threads);
+
+#endif
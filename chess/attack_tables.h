@@ -0,0 +1,55 @@
+#ifndef ATTACK_TABLES_H
+#define ATTACK_TABLES_H
+#include <array>
+#include <cstdint>
+
+// Attack tables for the pieces that don't slide, generated at compile time. Squares are indexed like
+// Board::state (A1 = 0, H1 = 7, A2 = 8, ...). Each square has both a bitboard of the squares attacked from it
+// and the same squares as a list, for generators that want to loop over them.
+
+struct SquareTargets {
+    uint8_t count;
+    uint8_t squares[8];
+};
+
+struct AttackTable {
+    std::array<uint64_t, 64> attacks;
+    std::array<SquareTargets, 64> targets;
+};
+
+// Every square reached from each square by the given (file, rank) offsets, kept in the offsets' order
+template <size_t N>
+constexpr AttackTable generate_attack_table(const int (&offsets)[N][2]) {
+    AttackTable table{};
+    for (int square = 0; square < 64; square++) {
+        int file = square % 8;
+        int rank = square / 8;
+        SquareTargets& targets = table.targets[square];
+        for (size_t i = 0; i < N; i++) {
+            int target_file = file + offsets[i][0];
+            int target_rank = rank + offsets[i][1];
+            if (target_file < 0 || target_file > 7 || target_rank < 0 || target_rank > 7) {
+                continue;
+            }
+            int target = target_rank * 8 + target_file;
+            table.attacks[square] |= 1ULL << target;
+            targets.squares[targets.count++] = static_cast<uint8_t>(target);
+        }
+    }
+    return table;
+}
+
+constexpr int KNIGHT_OFFSETS[8][2] = {{-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {-2, -1}, {-2, 1}, {2, -1}, {2, 1}};
+constexpr int KING_OFFSETS[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+constexpr int WHITE_PAWN_OFFSETS[2][2] = {{-1, 1}, {1, 1}};
+constexpr int BLACK_PAWN_OFFSETS[2][2] = {{-1, -1}, {1, -1}};
+
+inline constexpr AttackTable KNIGHT_ATTACKS = generate_attack_table(KNIGHT_OFFSETS);
+inline constexpr AttackTable KING_ATTACKS = generate_attack_table(KING_OFFSETS);
+
+// Capture squares of a pawn, indexed by its color (0 = white, 1 = black). Read the other way around, these are
+// also the squares an enemy pawn must stand on to attack the square.
+inline constexpr AttackTable PAWN_ATTACKS[2] = {generate_attack_table(WHITE_PAWN_OFFSETS),
+                                                generate_attack_table(BLACK_PAWN_OFFSETS)};
+
+#endif
@@ -1,5 +1,4 @@
 #include <sstream>
-#include <cassert>
 #include <cmath>
 #include <limits>
 #include "board.h"
@@ -7,6 +6,8 @@
 #include "move.h"
 #include "game.h"
 #include "gui.h"
+#include "zobrist.h"
+#include "attack_tables.h"
 
 void Board::display() const {
     for (int rank = 7; rank >= 0; rank--) {
@@ -25,35 +26,174 @@ Board Board::inspect_move(Move& move, Color player) {
     return new_board;
 }
 
-double Board::score_position(Color player_to_move, int depth, double material_weight, double king_safety_weight) {
+double Board::score_position(Color player_to_move, int depth, const EvalParams& params) {
+    return score_position(player_to_move, depth, params, is_checked(player_to_move));
+}
+
+double Board::score_position(Color player_to_move, int depth, const EvalParams& params, bool in_check) {
     // Evaluate position without any recursion (for leaf nodes in bot)
     // Lower scores favor black, higher scores favor white
-    
+    double score;
+    if (score_game_over(player_to_move, depth, in_check, score)) {
+        return score;
+    }
+
+    // BOARD EVALUATION
+    return evaluate(params);
+}
+
+bool Board::score_game_over(Color player_to_move, int depth, bool in_check, double& score) {
+    TerminalState terminal_state = get_terminal_state(player_to_move, in_check);
+
     // CHECKMATE
-    if (is_checkmated(*this, player_to_move)) {
-        if (player_to_move == WHITE) { return -1000000 + depth; }
-        if (player_to_move == BLACK) { return 1000000 - depth; }
-        assert(false); // should never reach this!
+    if (terminal_state == CHECKMATED) {
+        score = (player_to_move == WHITE) ? -1000000 + depth : 1000000 - depth;
+        return true;
     }
 
     // DRAWS
-    if (is_stalemated(*this, player_to_move)) { return 0.0; }
-    if (threefold_repetition_draw(*this)) { return 0.0; }
-    if (fifty_move_rule_draw(*this)) { return 0.0; }
+    if (terminal_state == STALEMATED || threefold_repetition_draw(*this) || fifty_move_rule_draw(*this)) {
+        score = 0.0;
+        return true;
+    }
+    return false;
+}
 
-    // BOARD EVALUATION
-    double material     = calculate_raw_material_score();
-    // double mobility     = calculate_mobility_difference();
-    double kingSafety   = evaluate_king_safety();
-    // double pawnStructure = evaluate_pawn_structure();
+double Board::evaluate(const EvalParams& params) {
+    return evaluate_features(get_eval_features(), params);
+}
+
+EvalFeatures Board::get_eval_features() {
+    EvalFeatures features = {};
+    for (int i = 0; i < 64; i++) {
+        switch(state[i]) {
+            case WHITE_PAWN: features.pawns++; break;
+            case WHITE_KNIGHT: features.knights++; break;
+            case WHITE_BISHOP: features.bishops++; break;
+            case WHITE_ROOK: features.rooks++; break;
+            case WHITE_QUEEN: features.queens++; break;
+            case BLACK_PAWN: features.pawns--; break;
+            case BLACK_KNIGHT: features.knights--; break;
+            case BLACK_BISHOP: features.bishops--; break;
+            case BLACK_ROOK: features.rooks--; break;
+            case BLACK_QUEEN: features.queens--; break;
+            default: break;
+        }
+    }
+
+    features.king_safety = evaluate_king_safety();
+    features.pawn_structure = evaluate_pawn_structure();
+    evaluate_attack_maps(features);
+    return features;
+}
+
+// Everything the attack-map evaluation terms need, built in one pass over the board
+struct AttackMaps {
+    uint64_t occupied[2];     // by color
+    uint64_t attacks[2];      // every square attacked by the color
+    uint64_t pawn_attacks[2];
+    int mobility[2][4];       // knight, bishop, rook, queen
+};
+
+static int popcount(uint64_t bits) {
+    return __builtin_popcountll(bits);
+}
+
+void Board::build_attack_maps(AttackMaps& maps) {
+    maps = {};
+    for (int i = 0; i < 64; i++) {
+        if (state[i] == EMPTY) {
+            continue;
+        }
+        bool is_white = (state[i] >= WHITE_PAWN && state[i] <= WHITE_KING);
+        maps.occupied[is_white ? WHITE : BLACK] |= 1ULL << i;
+        if (state[i] == WHITE_PAWN || state[i] == BLACK_PAWN) {
+            Color color = is_white ? WHITE : BLACK;
+            maps.pawn_attacks[color] |= PAWN_ATTACKS[color].attacks[i];
+        }
+    }
+    maps.attacks[WHITE] = maps.pawn_attacks[WHITE];
+    maps.attacks[BLACK] = maps.pawn_attacks[BLACK];
+
+    // Pieces: mobility counts the attacked squares not holding an own piece or covered by an enemy pawn
+    static const int directions[8][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    for (int i = 0; i < 64; i++) {
+        Piece piece = state[i];
+        if (piece == EMPTY || piece == WHITE_PAWN || piece == BLACK_PAWN) {
+            continue;
+        }
+        Color color = (piece >= WHITE_PAWN && piece <= WHITE_KING) ? WHITE : BLACK;
+        Color opponent = (color == WHITE) ? BLACK : WHITE;
+
+        uint64_t attacks = 0;
+        int type = -1; // index into mobility
+        int first_direction = 0, last_direction = 0;
+        switch (piece) {
+            case WHITE_KNIGHT: case BLACK_KNIGHT: attacks = KNIGHT_ATTACKS.attacks[i]; type = 0; break;
+            case WHITE_KING: case BLACK_KING: attacks = KING_ATTACKS.attacks[i]; break;
+            case WHITE_BISHOP: case BLACK_BISHOP: type = 1; first_direction = 0; last_direction = 4; break;
+            case WHITE_ROOK: case BLACK_ROOK: type = 2; first_direction = 4; last_direction = 8; break;
+            default: type = 3; first_direction = 0; last_direction = 8; break;
+        }
+        for (int d = first_direction; d < last_direction; d++) {
+            int f = i % 8 + directions[d][0];
+            int r = i / 8 + directions[d][1];
+            for (; f >= 0 && f < 8 && r >= 0 && r < 8; f += directions[d][0], r += directions[d][1]) {
+                attacks |= 1ULL << (r * 8 + f);
+                if (state[r * 8 + f] != EMPTY) {
+                    break;
+                }
+            }
+        }
 
-    return material * material_weight + kingSafety * king_safety_weight;// + pawnStructure * pawn_structure_weight + mobility * mobility_weight
+        maps.attacks[color] |= attacks;
+        if (type >= 0) {
+            maps.mobility[color][type] += popcount(attacks & ~maps.occupied[color] & ~maps.pawn_attacks[opponent]);
+        }
+    }
 }
 
-double Board::calculate_mobility_difference() {
-    vector<Move> white_moves = get_legal_moves(WHITE);
-    vector<Move> black_moves = get_legal_moves(BLACK);
-    return 1.0 * (white_moves.size() - black_moves.size());
+void Board::evaluate_attack_maps(EvalFeatures& features) {
+    AttackMaps maps;
+    build_attack_maps(maps);
+
+    features.knight_mobility = maps.mobility[WHITE][0] - maps.mobility[BLACK][0];
+    features.bishop_mobility = maps.mobility[WHITE][1] - maps.mobility[BLACK][1];
+    features.rook_mobility = maps.mobility[WHITE][2] - maps.mobility[BLACK][2];
+    features.queen_mobility = maps.mobility[WHITE][3] - maps.mobility[BLACK][3];
+
+    for (Color color : {WHITE, BLACK}) {
+        Color opponent = (color == WHITE) ? BLACK : WHITE;
+        int sign = (color == WHITE) ? 1 : -1;
+
+        // King zone: the king's square and its neighbours. The shield is the own pawns on the three files
+        // around the king, one or two ranks in front of it.
+        int king = king_squares[color];
+        if (king >= 0) {
+            uint64_t zone = KING_ATTACKS.attacks[king] | (1ULL << king);
+            features.king_zone_attacks -= sign * popcount(maps.attacks[opponent] & zone);
+
+            Piece own_pawn = (color == WHITE) ? WHITE_PAWN : BLACK_PAWN;
+            int forward = (color == WHITE) ? 1 : -1;
+            for (int df = -1; df <= 1; df++) {
+                for (int ranks = 1; ranks <= 2; ranks++) {
+                    if (get_piece(king % 8 + df, king / 8 + forward * ranks) == own_pawn) {
+                        features.pawn_shield += sign;
+                    }
+                }
+            }
+        }
+
+        // Hanging: knights, bishops, rooks and queens attacked and not defended
+        uint64_t pieces = maps.occupied[color];
+        uint64_t hanging = pieces & maps.attacks[opponent] & ~maps.attacks[color];
+        for (; hanging != 0; hanging &= hanging - 1) {
+            Piece piece = state[__builtin_ctzll(hanging)];
+            if (piece != WHITE_PAWN && piece != BLACK_PAWN && piece != WHITE_KING && piece != BLACK_KING) {
+                features.hanging_pieces -= sign;
+            }
+        }
+    }
 }
 
 double Board::evaluate_king_safety() {
@@ -62,7 +202,7 @@ double Board::evaluate_king_safety() {
     const double threshold  = 3.0;    // Distance below which penalty applies
 
     // Evaluate white king
-    int white_king_index = get_lowest_piece_index(WHITE_KING);
+    int white_king_index = king_squares[WHITE];
     int white_file = white_king_index % 8;
     int white_rank = white_king_index / 8;
     double white_d = std::sqrt(std::pow(white_file - 3.5, 2) + std::pow(white_rank - 3.5, 2));
@@ -70,7 +210,7 @@ double Board::evaluate_king_safety() {
     score -= white_penalty;
     
     // Evaluate black king (penalty for black king in center is good for white)
-    int black_king_index = get_lowest_piece_index(BLACK_KING);
+    int black_king_index = king_squares[BLACK];
     int black_file = black_king_index % 8;
     int black_rank = black_king_index / 8;
     double black_d = std::sqrt(std::pow(black_file - 3.5, 2) + std::pow(black_rank - 3.5, 2));
@@ -83,58 +223,200 @@ double Board::evaluate_king_safety() {
 double Board::evaluate_pawn_structure() {
     double score = 0.0;
 
-    // Simple check for isolated pawns.
+    // Simple check for isolated pawns: count the pawns on each file first.
+    int white_pawns_on_file[8] = {0};
+    int black_pawns_on_file[8] = {0};
     for (int i = 0; i < 64; i++) {
-        Piece piece = state[i];
-        if (piece == WHITE_PAWN || piece == BLACK_PAWN) {
-            int file = i % 8;
-            bool has_neighbor = false;
-            // Check adjacent files for a friendly pawn.
-            for (int j = 0; j < 64; j++) {
-                if (j == i) continue;
-                int other_file = j % 8;
-                if (std::abs(other_file - file) == 1 && state[j] == piece) {
-                    has_neighbor = true;
-                    break;
-                }
-            }
+        if (state[i] == WHITE_PAWN) { white_pawns_on_file[i % 8]++; }
+        if (state[i] == BLACK_PAWN) { black_pawns_on_file[i % 8]++; }
+    }
+
+    for (int file = 0; file < 8; file++) {
+        bool white_neighbor = (file > 0 && white_pawns_on_file[file - 1]) || (file < 7 && white_pawns_on_file[file + 1]);
+        bool black_neighbor = (file > 0 && black_pawns_on_file[file - 1]) || (file < 7 && black_pawns_on_file[file + 1]);
+
+        // Penalize if no neighboring pawn (an isolated black pawn is a bonus for white)
+        if (!white_neighbor) { score -= 0.2 * white_pawns_on_file[file]; }
+        if (!black_neighbor) { score += 0.2 * black_pawns_on_file[file]; }
+    }
+    return score;
+}
+
+vector<Move> Board::get_legal_moves(Color player) {
+    return generate_moves(player, true);
+}
+
+vector<Move> Board::get_pseudo_legal_moves(Color player) {
+    return generate_moves(player, false);
+}
+
+LegalityInfo Board::get_legality_info(Color player) {
+    return get_legality_info(player, is_checked(player));
+}
+
+LegalityInfo Board::get_legality_info(Color player, bool in_check) {
+    Color opponent = (player == WHITE) ? BLACK : WHITE;
+    LegalityInfo info;
+    info.king_index = king_squares[player];
+    info.in_check = in_check;
+    info.pinned = (info.king_index < 0) ? 0 : line_blockers(info.king_index, player, opponent);
+    return info;
+}
+
+CheckInfo Board::get_check_info(Color player) {
+    Color opponent = (player == WHITE) ? BLACK : WHITE;
+    CheckInfo info = {king_squares[opponent], 0, 0, 0};
+    if (info.enemy_king >= 0) {
+        info.knight_checks = KNIGHT_ATTACKS.attacks[info.enemy_king];
+        // A pawn checks from the squares an enemy pawn on the king's square would capture on
+        info.pawn_checks = PAWN_ATTACKS[opponent].attacks[info.enemy_king];
+        info.discoverers = line_blockers(info.enemy_king, player, player);
+    }
+    return info;
+}
+
+bool Board::gives_check(const Move& move, Color player) {
+    return gives_check(move, player, get_check_info(player));
+}
+
+bool Board::gives_check(const Move& move, Color player, const CheckInfo& info) {
+    if (info.enemy_king < 0) {
+        return false;
+    }
 
-            // Penalize if no neighboring pawn.
-            if (!has_neighbor) {
-                if (piece == WHITE_PAWN)
-                    score -= 0.2;
-                else
-                    score += 0.2;  // Isolated black pawn is bad for black, so bonus for white.
+    // Castling, en passant and promotions move or remove a second piece: just play them out
+    std::string notation = move.get_move();
+    int src_index = (notation.size() >= 4) ? (notation[1] - '1') * 8 + (notation[0] - 'a') : -1;
+    int dst_index = (notation.size() >= 4) ? (notation[3] - '1') * 8 + (notation[2] - 'a') : -1;
+    Piece piece = (src_index >= 0) ? state[src_index] : EMPTY;
+    bool is_pawn = (piece == WHITE_PAWN || piece == BLACK_PAWN);
+    if (src_index < 0 || notation.size() != 4 || (is_pawn && (dst_index == en_passant_square || dst_index / 8 == 0 || dst_index / 8 == 7))) {
+        Color opponent = (player == WHITE) ? BLACK : WHITE;
+        Board after_move = *this;
+        after_move.update_move(move, player);
+        return after_move.is_checked(opponent);
+    }
+
+    int king_file = info.enemy_king % 8;
+    int king_rank = info.enemy_king / 8;
+
+    // Direct check
+    bool direct = false;
+    switch (piece) {
+        case WHITE_KNIGHT: case BLACK_KNIGHT:
+            direct = (info.knight_checks >> dst_index) & 1;
+            break;
+        case WHITE_PAWN: case BLACK_PAWN:
+            direct = (info.pawn_checks >> dst_index) & 1;
+            break;
+        case WHITE_BISHOP: case BLACK_BISHOP:
+        case WHITE_ROOK: case BLACK_ROOK:
+        case WHITE_QUEEN: case BLACK_QUEEN: {
+            int file_diff = dst_index % 8 - king_file;
+            int rank_diff = dst_index / 8 - king_rank;
+            bool straight = (file_diff == 0) != (rank_diff == 0);
+            bool diagonal = file_diff != 0 && std::abs(file_diff) == std::abs(rank_diff);
+            bool moves_straight = (piece != WHITE_BISHOP && piece != BLACK_BISHOP);
+            bool moves_diagonal = (piece != WHITE_ROOK && piece != BLACK_ROOK);
+            if ((straight && moves_straight) || (diagonal && moves_diagonal)) {
+                // Nothing but the square being left may stand between the king and the destination
+                int step_file = (file_diff > 0) - (file_diff < 0);
+                int step_rank = (rank_diff > 0) - (rank_diff < 0);
+                int blocker = first_occupied(info.enemy_king, step_file, step_rank, src_index);
+                int blocker_distance = std::max(std::abs(blocker % 8 - king_file), std::abs(blocker / 8 - king_rank));
+                direct = blocker < 0 || blocker_distance >= std::max(std::abs(file_diff), std::abs(rank_diff));
             }
+            break;
         }
+        default:
+            break;
     }
-    return score;
+    if (direct) {
+        return true;
+    }
+
+    // Discovered check: the piece leaves the line between the king and one of our sliders
+    if ((info.discoverers >> src_index) & 1) {
+        int src_file_diff = src_index % 8 - king_file;
+        int src_rank_diff = src_index / 8 - king_rank;
+        int dst_file_diff = dst_index % 8 - king_file;
+        int dst_rank_diff = dst_index / 8 - king_rank;
+        // Same line from the king: the cross products vanish and both lie on the same side
+        bool same_line = src_file_diff * dst_rank_diff == src_rank_diff * dst_file_diff &&
+                         src_file_diff * dst_file_diff >= 0 && src_rank_diff * dst_rank_diff >= 0;
+        return !same_line;
+    }
+    return false;
 }
 
-double Board::calculate_raw_material_score() {
+uint64_t Board::line_blockers(int king_square, Color blocker_color, Color slider_color) {
+    Piece rook = (slider_color == WHITE) ? WHITE_ROOK : BLACK_ROOK;
+    Piece bishop = (slider_color == WHITE) ? WHITE_BISHOP : BLACK_BISHOP;
+    Piece queen = (slider_color == WHITE) ? WHITE_QUEEN : BLACK_QUEEN;
 
-    double material_score = 0.0;
-    for (int i = 0; i < 64; i++) {
-        switch(state[i]) {
-            case EMPTY: break;
-            case WHITE_PAWN: material_score += 1.0; break;
-            case WHITE_ROOK: material_score += 5.0; break;
-            case WHITE_KNIGHT: material_score += 3.0; break;
-            case WHITE_BISHOP: material_score += 3.0; break;
-            case WHITE_QUEEN: material_score += 9.0; break;
-            case BLACK_PAWN: material_score -= 1.0; break;
-            case BLACK_ROOK: material_score -= 5.0; break;
-            case BLACK_KNIGHT: material_score -= 3.0; break;
-            case BLACK_BISHOP: material_score -= 3.0; break;
-            case BLACK_QUEEN: material_score -= 9.0; break;
-            default: break;
+    // Walk out from the king: a blocker followed by a slider moving along that line
+    uint64_t blockers = 0;
+    for (int df = -1; df <= 1; df++) {
+        for (int dr = -1; dr <= 1; dr++) {
+            if (df == 0 && dr == 0) {
+                continue;
+            }
+            int blocker = first_occupied(king_square, df, dr, -1);
+            if (blocker < 0) {
+                continue;
+            }
+            bool blocker_is_white = (state[blocker] >= WHITE_PAWN && state[blocker] <= WHITE_KING);
+            if (blocker_is_white != (blocker_color == WHITE)) {
+                continue;
+            }
+            int behind = first_occupied(blocker, df, dr, -1);
+            Piece slider = (df == 0 || dr == 0) ? rook : bishop;
+            if (behind >= 0 && (state[behind] == slider || state[behind] == queen)) {
+                blockers |= 1ULL << blocker;
+            }
         }
     }
+    return blockers;
+}
 
-    return material_score;
+int Board::first_occupied(int square, int step_file, int step_rank, int skip) {
+    int f = square % 8 + step_file;
+    int r = square / 8 + step_rank;
+    for (; f >= 0 && f < 8 && r >= 0 && r < 8; f += step_file, r += step_rank) {
+        int index = r * 8 + f;
+        if (state[index] != EMPTY && index != skip) {
+            return index;
+        }
+    }
+    return -1;
 }
 
-vector<Move> Board::get_legal_moves(Color player) {
+void Board::locate_kings() {
+    king_squares[WHITE] = get_lowest_piece_index(WHITE_KING);
+    king_squares[BLACK] = get_lowest_piece_index(BLACK_KING);
+}
+
+bool Board::is_pseudo_legal_move_legal(const Move& move, Color player, const LegalityInfo& info) {
+    // Castling is only generated when it is legal
+    std::string notation = move.get_move();
+    if (notation == "oo" || notation == "ooo") {
+        return true;
+    }
+
+    int src_index = (notation[1] - '1') * 8 + (notation[0] - 'a');
+    int dst_index = (notation[3] - '1') * 8 + (notation[2] - 'a');
+    Piece piece = state[src_index];
+    bool is_king = (piece == WHITE_KING || piece == BLACK_KING);
+    bool is_en_passant = (piece == WHITE_PAWN || piece == BLACK_PAWN) && dst_index == en_passant_square;
+
+    // Only king moves, moves out of check, moves of pinned pieces and en passant can expose the king
+    if (!info.in_check && !is_king && !is_en_passant && !((info.pinned >> src_index) & 1)) {
+        return true;
+    }
+    return !pinned_move(player, src_index, dst_index);
+}
+
+vector<Move> Board::generate_moves(Color player, bool check_pins) {
 
     vector<Move> legal_moves;
 
@@ -158,24 +440,24 @@ vector<Move> Board::get_legal_moves(Color player) {
         }
 
         if (piece == WHITE_PAWN || piece == BLACK_PAWN) {
-            append_all_legal_pawn_moves(legal_moves, src_index, player);
+            append_all_legal_pawn_moves(legal_moves, src_index, player, check_pins);
         } else if (piece == WHITE_ROOK || piece == BLACK_ROOK) {
-            append_all_legal_rook_moves(legal_moves, src_index, player);
+            append_all_legal_rook_moves(legal_moves, src_index, player, check_pins);
         } else if (piece == WHITE_KNIGHT || piece == BLACK_KNIGHT) {
-            append_all_legal_knight_moves(legal_moves, src_index, player);
+            append_all_legal_knight_moves(legal_moves, src_index, player, check_pins);
         } else if (piece == WHITE_BISHOP || piece == BLACK_BISHOP) {
-            append_all_legal_bishop_moves(legal_moves, src_index, player);
+            append_all_legal_bishop_moves(legal_moves, src_index, player, check_pins);
         } else if (piece == WHITE_QUEEN || piece == BLACK_QUEEN) {
-            append_all_legal_queen_moves(legal_moves, src_index, player);
+            append_all_legal_queen_moves(legal_moves, src_index, player, check_pins);
         } else if (piece == WHITE_KING || piece == BLACK_KING) {
-            append_all_legal_king_moves(legal_moves, src_index, player);
+            append_all_legal_king_moves(legal_moves, src_index, player, check_pins);
         }
     }
 
     return legal_moves;
 }
 
-void Board::append_all_legal_pawn_moves(vector<Move>& legal_moves, int src_index, Color player) {
+void Board::append_all_legal_pawn_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins) {
     // legal moves: (UNPINNED) 1 step forward, 2 step forward, left diagonal capture, right diagonal capture, promotions if on back rank!
 
     int src_file = src_index % 8;
@@ -186,7 +468,7 @@ void Board::append_all_legal_pawn_moves(vector<Move>& legal_moves, int src_index
 
     // One square forward
     int dst_index = ((src_rank+direction)*8) + src_file;
-    if (state[dst_index] == EMPTY && !pinned_move(player, src_index, dst_index)) {
+    if (state[dst_index] == EMPTY && (!check_pins || !pinned_move(player, src_index, dst_index))) {
         legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
         
         // Backrank promotion
@@ -197,41 +479,23 @@ void Board::append_all_legal_pawn_moves(vector<Move>& legal_moves, int src_index
         }
     }
 
-    // Left diagonal capture (including en passant and capture with promotion)
-    if (src_file > 0) {
-        int left_cap_idx = ((src_rank+direction)*8) + src_file - 1;
-        if (state[left_cap_idx] != EMPTY) {
-            bool captured_piece_is_white = (state[left_cap_idx] >= WHITE_PAWN && state[left_cap_idx] <= WHITE_KING);
-            if ((((player == WHITE) && !captured_piece_is_white) || ((player == BLACK && captured_piece_is_white)) || en_passant_square == left_cap_idx)
-                    && !pinned_move(player, src_index, dst_index)) {
-                legal_moves.push_back(Move(all_squares[src_index] + all_squares[left_cap_idx]));
-            }
-
-            // Backrank promotion
-            if (src_rank+direction == back_rank) {
-                legal_moves.push_back(Move(all_squares[src_index] + all_squares[left_cap_idx] + "pR"));
-                legal_moves.push_back(Move(all_squares[src_index] + all_squares[left_cap_idx] + "pN"));
-                legal_moves.push_back(Move(all_squares[src_index] + all_squares[left_cap_idx] + "pB"));
-            }
+    // Diagonal captures (including en passant and capture with promotion)
+    const SquareTargets& captures = PAWN_ATTACKS[player].targets[src_index];
+    for (int i = 0; i < captures.count; i++) {
+        int cap_idx = captures.squares[i];
+        Piece captured = state[cap_idx];
+        bool captured_piece_is_white = (captured >= WHITE_PAWN && captured <= WHITE_KING);
+        bool is_capture = (captured != EMPTY && ((player == WHITE) != captured_piece_is_white)) || is_en_passant_target(player, cap_idx);
+        if (!is_capture || (check_pins && pinned_move(player, src_index, cap_idx))) {
+            continue;
         }
-    }
+        legal_moves.push_back(Move(all_squares[src_index] + all_squares[cap_idx]));
 
-    // Right diagonal capture (including en passant and capture with promotion)
-    if (src_file < 7) {
-        int right_cap_idx = ((src_rank+direction)*8) + src_file + 1;
-        if (state[right_cap_idx] != EMPTY) {
-            bool captured_piece_is_white = (state[right_cap_idx] >= WHITE_PAWN && state[right_cap_idx] <= WHITE_KING);
-            if ((((player == WHITE) && !captured_piece_is_white) || ((player == BLACK && captured_piece_is_white)) || en_passant_square == right_cap_idx)
-                    && !pinned_move(player, src_index, dst_index)) {
-                legal_moves.push_back(Move(all_squares[src_index] + all_squares[right_cap_idx]));
-            }
-
-            // Backrank promotion
-            if (src_rank+direction == back_rank) {
-                legal_moves.push_back(Move(all_squares[src_index] + all_squares[right_cap_idx] + "pR"));
-                legal_moves.push_back(Move(all_squares[src_index] + all_squares[right_cap_idx] + "pN"));
-                legal_moves.push_back(Move(all_squares[src_index] + all_squares[right_cap_idx] + "pB"));
-            }
+        // Backrank promotion
+        if (src_rank+direction == back_rank) {
+            legal_moves.push_back(Move(all_squares[src_index] + all_squares[cap_idx] + "pR"));
+            legal_moves.push_back(Move(all_squares[src_index] + all_squares[cap_idx] + "pN"));
+            legal_moves.push_back(Move(all_squares[src_index] + all_squares[cap_idx] + "pB"));
         }
     }
 
@@ -239,13 +503,13 @@ void Board::append_all_legal_pawn_moves(vector<Move>& legal_moves, int src_index
     if (src_rank == start_rank) {
         int intermediate_index = ((start_rank+direction)*8) + src_file;
         int dst_index = ((start_rank+(direction*2))*8) + src_file;
-        if (state[intermediate_index] == EMPTY && state[dst_index] == EMPTY && !pinned_move(player, src_index, dst_index)) {
+        if (state[intermediate_index] == EMPTY && state[dst_index] == EMPTY && (!check_pins || !pinned_move(player, src_index, dst_index))) {
             legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
         }
     }
 }
 
-void Board::append_all_legal_rook_moves(vector<Move>& legal_moves, int src_index, Color player) {
+void Board::append_all_legal_rook_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins) {
     // legal moves: (UNPINNED) any horizontal or vertical move until another piece is in the way 
     int src_rank = src_index / 8;
     int src_file = src_index % 8;
@@ -261,14 +525,14 @@ void Board::append_all_legal_rook_moves(vector<Move>& legal_moves, int src_index
         while (f >= 0 && f < 8 && r >= 0 && r < 8) {
             int dst_index = r*8 + f;
             Piece piece = state[dst_index];
-            if (piece == EMPTY && !pinned_move(player, src_index, dst_index)) {
+            if (piece == EMPTY && (!check_pins || !pinned_move(player, src_index, dst_index))) {
                 // Can move to any empty square when nothing is in between
                 legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
             } else if (piece != EMPTY) {
                 // Can capture opponent pieces when nothing is in between
                 bool piece_is_white = (piece >= WHITE_PAWN && piece <= WHITE_KING);
                 if ((((player == WHITE) && !piece_is_white) || ((player == BLACK) && piece_is_white))
-                        && !pinned_move(player, src_index, dst_index)) {
+                        && (!check_pins || !pinned_move(player, src_index, dst_index))) {
                     legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
                 }
                 
@@ -283,37 +547,21 @@ void Board::append_all_legal_rook_moves(vector<Move>& legal_moves, int src_index
     }
 }
 
-void Board::append_all_legal_knight_moves(vector<Move>& legal_moves, int src_index, Color player) {
+void Board::append_all_legal_knight_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins) {
     // legal moves: (UNPINNED) any L move
-    int src_rank = src_index / 8;
-    int src_file = src_index % 8;
-
-    for (int file_offset : {-1, 1, -2, 2}) {
-        for (int rank_offset : {-1, 1, -2, 2}) {
-            if (abs(file_offset) == abs(rank_offset)) {
-                continue;
-            }
+    const SquareTargets& targets = KNIGHT_ATTACKS.targets[src_index];
+    for (int i = 0; i < targets.count; i++) {
+        int dst_index = targets.squares[i];
+        bool dst_piece_is_white = (state[dst_index] >= WHITE_PAWN && state[dst_index] <= WHITE_KING);
 
-            int dst_rank = src_rank + rank_offset;
-            int dst_file = src_file + file_offset;
-
-            // Ensure dst_index is on the board
-            if (dst_rank < 0 || dst_rank >= 8 || dst_file < 0 || dst_file >= 8) {
-                continue;
-            }
-
-            int dst_index = (dst_rank*8) + dst_file;
-            bool dst_piece_is_white = (state[dst_index] >= WHITE_PAWN && state[dst_index] <= WHITE_KING);
-
-            if ((state[dst_index] == EMPTY || (dst_piece_is_white && (player == BLACK)) || (!dst_piece_is_white && (player == WHITE)))
-                    && (!pinned_move(player, src_index, dst_index))) {
-                legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
-            }
+        if ((state[dst_index] == EMPTY || (dst_piece_is_white && (player == BLACK)) || (!dst_piece_is_white && (player == WHITE)))
+                && (!check_pins || !pinned_move(player, src_index, dst_index))) {
+            legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
         }
     }
 }
 
-void Board::append_all_legal_bishop_moves(vector<Move>& legal_moves, int src_index, Color player) {
+void Board::append_all_legal_bishop_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins) {
     // legal moves: (UNPINNED) any diagonal move until another piece is in the way 
     int src_rank = src_index / 8;
     int src_file = src_index % 8;
@@ -329,14 +577,14 @@ void Board::append_all_legal_bishop_moves(vector<Move>& legal_moves, int src_ind
         while (f >= 0 && f < 8 && r >= 0 && r < 8) {
             int dst_index = r*8 + f;
             Piece piece = state[dst_index];
-            if (piece == EMPTY && !pinned_move(player, src_index, dst_index)) {
+            if (piece == EMPTY && (!check_pins || !pinned_move(player, src_index, dst_index))) {
                 // Can move to any empty square when nothing is in between
                 legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
             } else if (piece != EMPTY) {
                 // Can capture opponent pieces when nothing is in between
                 bool piece_is_white = (piece >= WHITE_PAWN && piece <= WHITE_KING);
                 if ((((player == WHITE) && !piece_is_white) || ((player == BLACK) && piece_is_white))
-                        && !pinned_move(player, src_index, dst_index)) {
+                        && (!check_pins || !pinned_move(player, src_index, dst_index))) {
                     legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
                 }
                 
@@ -350,53 +598,102 @@ void Board::append_all_legal_bishop_moves(vector<Move>& legal_moves, int src_ind
     }
 }
 
-void Board::append_all_legal_queen_moves(vector<Move>& legal_moves, int src_index, Color player) {
+void Board::append_all_legal_queen_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins) {
     // legal moves: (UNPINNED) any diagonal/horizontal/vertical move until another piece is in the way 
-    append_all_legal_rook_moves(legal_moves, src_index, player);
-    append_all_legal_bishop_moves(legal_moves, src_index, player);
+    append_all_legal_rook_moves(legal_moves, src_index, player, check_pins);
+    append_all_legal_bishop_moves(legal_moves, src_index, player, check_pins);
 }
 
-void Board::append_all_legal_king_moves(vector<Move>& legal_moves, int src_index, Color player) {
+void Board::append_all_legal_king_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins) {
     // legal moves: 1 square any direction not into check
+    const SquareTargets& targets = KING_ATTACKS.targets[src_index];
+    for (int i = 0; i < targets.count; i++) {
+        int dst_index = targets.squares[i];
+        Piece piece = state[dst_index];
 
-    int src_rank = src_index / 8;
-    int src_file = src_index % 8;
+        if (piece == EMPTY && (!check_pins || !pinned_move(player, src_index, dst_index))) {
+            legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
+        }
 
-    for (int file_offset = -1; file_offset <= 1; file_offset++) {
-        for (int rank_offset = -1; rank_offset <= 1; rank_offset++) {
-            if (file_offset == 0 && rank_offset == 0) {
-                continue;
+        if (piece != EMPTY) {
+            // Can capture opponent pieces when nothing is in between
+            bool piece_is_white = (piece >= WHITE_PAWN && piece <= WHITE_KING);
+            if ((((player == WHITE) && !piece_is_white) || ((player == BLACK) && piece_is_white))
+                    && (!check_pins || !pinned_move(player, src_index, dst_index))) {
+                legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
             }
+        }
+    }
+}
 
-            int dst_rank = src_rank + rank_offset;
-            int dst_file = src_file + file_offset;
+bool Board::has_no_legal_moves(Color player) {
+    return !has_any_legal_move(player);
+}
 
-            if (dst_rank < 0 || dst_rank >= 8 || dst_file < 0 || dst_file >= 8) {
-                continue;
-            }
-            
-            int dst_index = dst_rank*8 + dst_file;
-            Piece piece = state[dst_index];
+bool Board::has_any_legal_move(Color player) {
+    return has_any_legal_move(player, is_checked(player));
+}
 
-            if (piece == EMPTY && !pinned_move(player, src_index, dst_index)) {
-                legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
-            }
+// Like get_legal_moves, but stops at the first piece that has a legal move instead of building the full list.
+// Castling never needs to be tried: a legal castle implies the king can legally step onto the rook's square.
+bool Board::has_any_legal_move(Color player, bool in_check) {
+    vector<Move> moves;
+    Piece king = (player == WHITE) ? WHITE_KING : BLACK_KING;
+    int king_index = king_squares[player];
+
+    // When in check, most pieces can't do anything about it... try the king first
+    if (in_check) {
+        append_all_legal_king_moves(moves, king_index, player);
+        if (!moves.empty()) {
+            return true;
+        }
+    }
 
-            if (piece != EMPTY) {
-                // Can capture opponent pieces when nothing is in between
-                bool piece_is_white = (piece >= WHITE_PAWN && piece <= WHITE_KING);
-                if ((((player == WHITE) && !piece_is_white) || ((player == BLACK) && piece_is_white))
-                        && !pinned_move(player, src_index, dst_index)) {
-                    legal_moves.push_back(Move(all_squares[src_index] + all_squares[dst_index]));
-                }
-            }
+    for (int src_index = 0; src_index < 64; src_index++) {
+        Piece piece = state[src_index];
+        if (piece == EMPTY || piece == king) {
+            continue;
+        }
+
+        Color piece_color = piece >= WHITE_PAWN && piece <= WHITE_KING ? WHITE : BLACK;
+        if (piece_color != player) {
+            continue;
+        }
 
+        if (piece == WHITE_PAWN || piece == BLACK_PAWN) {
+            append_all_legal_pawn_moves(moves, src_index, player);
+        } else if (piece == WHITE_ROOK || piece == BLACK_ROOK) {
+            append_all_legal_rook_moves(moves, src_index, player);
+        } else if (piece == WHITE_KNIGHT || piece == BLACK_KNIGHT) {
+            append_all_legal_knight_moves(moves, src_index, player);
+        } else if (piece == WHITE_BISHOP || piece == BLACK_BISHOP) {
+            append_all_legal_bishop_moves(moves, src_index, player);
+        } else if (piece == WHITE_QUEEN || piece == BLACK_QUEEN) {
+            append_all_legal_queen_moves(moves, src_index, player);
+        }
+
+        if (!moves.empty()) {
+            return true;
         }
     }
+
+    if (!in_check) {
+        append_all_legal_king_moves(moves, king_index, player);
+    }
+
+    return !moves.empty();
 }
 
-bool Board::has_no_legal_moves(Color player) {
-    return get_legal_moves(player).empty();
+// Checkmate and stalemate in a single pass: one check test and (at most) one partial move generation.
+TerminalState Board::get_terminal_state(Color player) {
+    return get_terminal_state(player, is_checked(player));
+}
+
+TerminalState Board::get_terminal_state(Color player, bool in_check) {
+    if (has_any_legal_move(player, in_check)) {
+        return NOT_TERMINAL;
+    }
+    return in_check ? CHECKMATED : STALEMATED;
 }
 
 bool Board::is_legal_move(const Move& move, Color player) {
@@ -577,13 +874,19 @@ bool Board::is_legal_pawn_move(std::string notation, Color player, int src_index
     }
 
     // En passant capture
-    if (abs_file_diff == 1 && rank_diff == direction && dst_index == en_passant_square) {
+    if (abs_file_diff == 1 && rank_diff == direction && is_en_passant_target(player, dst_index)) {
         return (!pinned_move(player, src_index, dst_index));
     }
     
     return false;
 }
 
+// The en passant square only counts for the side whose opponent just double-pushed: it must sit on that
+// opponent's third rank (rank 6 when white captures, rank 3 when black does)
+bool Board::is_en_passant_target(Color player, int dst_index) const {
+    return dst_index == en_passant_square && dst_index / 8 == ((player == WHITE) ? 5 : 2);
+}
+
 bool Board::is_legal_knight_move(Color player, int src_index, int dst_index) {
     int src_file = src_index % 8;
     int src_rank = src_index / 8;
@@ -754,15 +1057,10 @@ bool Board::is_under_attack_from_king(int file, int rank, Color player) {
         attacker = WHITE_KING;
     }
 
-    for (int file_offset = -1; file_offset <= 1; file_offset++) {
-        for (int rank_offset = -1; rank_offset <= 1; rank_offset++) {
-            if (file_offset == 0 && rank_offset == 0) {
-                continue;
-            }
-            
-            if (get_piece(file + file_offset, rank + rank_offset) == attacker) {
-                return true;
-            }
+    const SquareTargets& targets = KING_ATTACKS.targets[rank * 8 + file];
+    for (int i = 0; i < targets.count; i++) {
+        if (state[targets.squares[i]] == attacker) {
+            return true;
         }
     }
 
@@ -773,18 +1071,16 @@ bool Board::is_under_attack_from_king(int file, int rank, Color player) {
 // Check if player's piece at file/rank is under attack from an opposing pawn.
 bool Board::is_under_attack_from_pawn(int file, int rank, Color player) {
     Piece attacker = BLACK_PAWN;
-    int rank_offset = 1;
     if (player == BLACK) {
         attacker = WHITE_PAWN;
-        rank_offset = -1;
     }
 
-    if (get_piece(file + 1, rank + rank_offset) == attacker) {
-        return true;
-    }
-    
-    if (get_piece(file - 1, rank + rank_offset) == attacker) {
-        return true;
+    // Enemy pawns attack this square from the squares our own pawn would capture on
+    const SquareTargets& targets = PAWN_ATTACKS[player].targets[rank * 8 + file];
+    for (int i = 0; i < targets.count; i++) {
+        if (state[targets.squares[i]] == attacker) {
+            return true;
+        }
     }
 
     return false;
@@ -797,15 +1093,10 @@ bool Board::is_under_attack_from_knight(int file, int rank, Color player) {
         attacker = WHITE_KNIGHT;
     }
 
-    for (int short_offset : {-1, 1}) {
-        for (int long_offset : {-2, 2}) {
-            if (get_piece(file + short_offset, rank + long_offset) == attacker) {
-                return true;
-            }
-
-            if (get_piece(file + long_offset, rank + short_offset) == attacker) {
-                return true;
-            }
+    const SquareTargets& targets = KNIGHT_ATTACKS.targets[rank * 8 + file];
+    for (int i = 0; i < targets.count; i++) {
+        if (state[targets.squares[i]] == attacker) {
+            return true;
         }
     }
 
@@ -889,6 +1180,11 @@ bool Board::is_under_attack_from_straight(int file, int rank, Color player) {
 
 bool Board::is_square_under_attack(int file, int rank, Color player) {
 
+    // Nothing attacks a square off the board (a missing king is looked up as -1)
+    if (file < 0 || file > 7 || rank < 0 || rank > 7) {
+        return false;
+    }
+
     // Check if the square is under attack from a king
     bool under_attack = is_under_attack_from_king(file, rank, player);
 
@@ -919,27 +1215,45 @@ bool Board::pinned_move(Color player, int src_index, int dst_index) {
     // Assumes that move is completely valid and possible!
     // Checks to see if after moving, the king would be in check, making it an invalid move.
 
+    // En passant also removes the captured pawn, which can uncover a check along the rank
+    int captured_index = -1;
+    Piece piece = state[src_index];
+    if ((piece == WHITE_PAWN || piece == BLACK_PAWN) && dst_index == en_passant_square && src_index % 8 != dst_index % 8) {
+        captured_index = (src_index / 8) * 8 + dst_index % 8;
+    }
+    Piece captured = (captured_index != -1) ? state[captured_index] : EMPTY;
+
     // Temporarily make move to see board after move
+    bool is_king = (piece == WHITE_KING || piece == BLACK_KING);
     Piece temp = state[dst_index];
     state[dst_index] = state[src_index];
     state[src_index] = EMPTY;
+    if (captured_index != -1) {
+        state[captured_index] = EMPTY;
+    }
+    if (is_king) {
+        king_squares[player] = dst_index;
+    }
 
     bool under_attack = is_checked(player);
 
     // Undo temporary move
     state[src_index] = state[dst_index];
     state[dst_index] = temp;
+    if (captured_index != -1) {
+        state[captured_index] = captured;
+    }
+    if (is_king) {
+        king_squares[player] = src_index;
+    }
 
     return under_attack;
 }
 
 bool Board::is_checked(Color player) {
-    // Determine index of king
-    int king_index = 0;
-    if (player == WHITE) {
-        king_index = get_lowest_piece_index(WHITE_KING);
-    } else {
-        king_index = get_lowest_piece_index(BLACK_KING);
+    int king_index = king_squares[player];
+    if (king_index < 0) {
+        return false;
     }
 
     // Check if king_index is currently under attack by opposing pieces
@@ -948,6 +1262,187 @@ bool Board::is_checked(Color player) {
     return is_square_under_attack(king_file, king_rank, player);
 }
 
+int Board::get_ply_count() const {
+    return ply_count;
+}
+
+int Board::get_draw_move_counter() const {
+    return draw_move_counter;
+}
+
+// Index of the square a pawn can capture en passant onto, or -1.
+int Board::get_en_passant_square() const {
+    return en_passant_square;
+}
+
+bool Board::has_castling_rights() const {
+    return white_can_oo || white_can_ooo || black_can_oo || black_can_ooo;
+}
+
+// Zobrist hash of the position (Polyglot layout, see zobrist.h).
+// En passant only counts when a pawn of the side to move could actually capture. 'piece_at(file, rank)' gives
+// the board to look at (EMPTY off the board).
+template <typename PieceAt>
+static uint64_t en_passant_hash(int en_passant_square, Color player_to_move, PieceAt piece_at) {
+    if (en_passant_square == -1) {
+        return 0;
+    }
+    int ep_file = en_passant_square % 8;
+    Piece capturer = (player_to_move == WHITE) ? WHITE_PAWN : BLACK_PAWN;
+    int capturer_rank = (player_to_move == WHITE) ? 4 : 3;
+    if (piece_at(ep_file - 1, capturer_rank) == capturer || piece_at(ep_file + 1, capturer_rank) == capturer) {
+        return Zobrist::en_passant_key(ep_file);
+    }
+    return 0;
+}
+
+uint64_t Board::get_hash(Color player_to_move) {
+    uint64_t hash = 0;
+    for (int i = 0; i < 64; i++) {
+        if (state[i] != EMPTY) {
+            hash ^= Zobrist::piece_key(state[i], i);
+        }
+    }
+
+    if (white_can_oo)  { hash ^= Zobrist::castling_key(0); }
+    if (white_can_ooo) { hash ^= Zobrist::castling_key(1); }
+    if (black_can_oo)  { hash ^= Zobrist::castling_key(2); }
+    if (black_can_ooo) { hash ^= Zobrist::castling_key(3); }
+
+    hash ^= en_passant_hash(en_passant_square, player_to_move, [this](int file, int rank) {
+        return get_piece(file, rank);
+    });
+
+    if (player_to_move == WHITE) {
+        hash ^= Zobrist::side_key();
+    }
+
+    return hash;
+}
+
+// The piece a pawn of 'player' promotes to for a promotion letter (as in "e7e8pN"); anything else is a queen
+static Piece promotion_piece(Color player, char piece_char) {
+    switch (piece_char) {
+        case 'B': return (player == WHITE) ? WHITE_BISHOP : BLACK_BISHOP;
+        case 'R': return (player == WHITE) ? WHITE_ROOK : BLACK_ROOK;
+        case 'N': return (player == WHITE) ? WHITE_KNIGHT : BLACK_KNIGHT;
+        default: return (player == WHITE) ? WHITE_QUEEN : BLACK_QUEEN;
+    }
+}
+
+// Mirrors update_move: the squares it changes, the castling rights the move takes away (moving the king or a rook,
+// or capturing a rook on its corner) and the new en passant square (cleared by every move but a double push,
+// castling included)
+uint64_t Board::hash_after_move(uint64_t hash, const Move& move, Color player) {
+    Color opponent = (player == WHITE) ? BLACK : WHITE;
+    auto piece_at = [this](int file, int rank) { return get_piece(file, rank); };
+    hash ^= en_passant_hash(en_passant_square, player, piece_at);
+    hash ^= Zobrist::side_key();
+
+    // Squares whose piece changes, with the piece they end up with
+    int squares[4];
+    Piece pieces[4];
+    int changes = 0;
+    auto set_square = [&](int index, Piece piece) {
+        squares[changes] = index;
+        pieces[changes] = piece;
+        changes++;
+    };
+
+    bool can_oo[2] = {white_can_oo, black_can_oo};
+    bool can_ooo[2] = {white_can_ooo, black_can_ooo};
+    int new_en_passant_square = en_passant_square;
+    std::string notation = move.get_move();
+    if (notation == "oo" || notation == "ooo") {
+        int back_rank = (player == WHITE) ? 0 : 56;
+        bool kingside = notation == "oo";
+        set_square(back_rank + 4, EMPTY);
+        set_square(back_rank + (kingside ? 7 : 0), EMPTY);
+        set_square(back_rank + (kingside ? 6 : 2), (player == WHITE) ? WHITE_KING : BLACK_KING);
+        set_square(back_rank + (kingside ? 5 : 3), (player == WHITE) ? WHITE_ROOK : BLACK_ROOK);
+        can_oo[player] = false;
+        can_ooo[player] = false;
+        new_en_passant_square = -1;
+    } else {
+        int src_rank = notation[1] - '1';
+        int dst_rank = notation[3] - '1';
+        int src_index = src_rank * 8 + (notation[0] - 'a');
+        int dst_index = dst_rank * 8 + (notation[2] - 'a');
+        Piece piece = state[src_index];
+
+        Piece placed = piece;
+        if ((piece == WHITE_PAWN && dst_rank == 7) || (piece == BLACK_PAWN && dst_rank == 0)) {
+            placed = promotion_piece(player, (notation.size() == 6) ? notation[5] : 'Q');
+        }
+        set_square(src_index, EMPTY);
+        set_square(dst_index, placed);
+        if (piece == WHITE_PAWN && dst_index == en_passant_square) {
+            set_square(dst_index - 8, EMPTY);
+        } else if (piece == BLACK_PAWN && dst_index == en_passant_square) {
+            set_square(dst_index + 8, EMPTY);
+        }
+
+        if (piece == WHITE_KING || piece == BLACK_KING) {
+            can_oo[player] = false;
+            can_ooo[player] = false;
+        } else if (piece == WHITE_ROOK && src_index == 0) {
+            can_ooo[WHITE] = false;
+        } else if (piece == WHITE_ROOK && src_index == 7) {
+            can_oo[WHITE] = false;
+        } else if (piece == BLACK_ROOK && src_index == 56) {
+            can_ooo[BLACK] = false;
+        } else if (piece == BLACK_ROOK && src_index == 63) {
+            can_oo[BLACK] = false;
+        }
+        if (dst_index == 0) {
+            can_ooo[WHITE] = false;
+        } else if (dst_index == 7) {
+            can_oo[WHITE] = false;
+        } else if (dst_index == 56) {
+            can_ooo[BLACK] = false;
+        } else if (dst_index == 63) {
+            can_oo[BLACK] = false;
+        }
+
+        if (piece == WHITE_PAWN && src_rank == 1 && dst_rank == 3) {
+            new_en_passant_square = src_index + 8;
+        } else if (piece == BLACK_PAWN && src_rank == 6 && dst_rank == 4) {
+            new_en_passant_square = src_index - 8;
+        } else {
+            new_en_passant_square = -1;
+        }
+    }
+
+    for (int i = 0; i < changes; i++) {
+        if (state[squares[i]] != EMPTY) {
+            hash ^= Zobrist::piece_key(state[squares[i]], squares[i]);
+        }
+        if (pieces[i] != EMPTY) {
+            hash ^= Zobrist::piece_key(pieces[i], squares[i]);
+        }
+    }
+
+    if (can_oo[WHITE] != white_can_oo)   { hash ^= Zobrist::castling_key(0); }
+    if (can_ooo[WHITE] != white_can_ooo) { hash ^= Zobrist::castling_key(1); }
+    if (can_oo[BLACK] != black_can_oo)   { hash ^= Zobrist::castling_key(2); }
+    if (can_ooo[BLACK] != black_can_ooo) { hash ^= Zobrist::castling_key(3); }
+
+    hash ^= en_passant_hash(new_en_passant_square, opponent, [&](int file, int rank) {
+        if (rank < 0 || rank >= 8 || file < 0 || file >= 8) {
+            return EMPTY;
+        }
+        int index = rank * 8 + file;
+        for (int i = changes - 1; i >= 0; i--) {
+            if (squares[i] == index) {
+                return pieces[i];
+            }
+        }
+        return state[index];
+    });
+
+    return hash;
+}
+
 bool Board::is_fifty_move_rule_draw() {
     return draw_move_counter >= 100;
 }
@@ -972,6 +1467,7 @@ void Board::update_move(const Move& move, Color player) {
 
     // Update Previous Move History
     handle_prev_move_history(notation);
+    ply_count++;
 
     if (notation == "oo") {
         castle_kingside(player);
@@ -997,9 +1493,12 @@ void Board::update_move(const Move& move, Color player) {
         }
 
         state[src_index] = EMPTY;
+        if (piece == WHITE_KING || piece == BLACK_KING) {
+            king_squares[player] = dst_index;
+        }
         
         // Castling
-        handle_castling_history(piece, src_index);
+        handle_castling_history(piece, src_index, dst_index);
 
         // En passant
         handle_en_passant_history(piece, src_rank, dst_rank, src_file);
@@ -1011,11 +1510,13 @@ void Board::update_move(const Move& move, Color player) {
 
 
 void Board::castle_kingside(Color player) {
+    en_passant_square = -1;
     if (player == WHITE) {
         state[7] = EMPTY; // old rook square
         state[4] = EMPTY; // old king square
         state[6] = WHITE_KING;
         state[5] = WHITE_ROOK;
+        king_squares[WHITE] = 6;
         white_can_oo = false;
         white_can_ooo = false;
     } else {
@@ -1023,17 +1524,20 @@ void Board::castle_kingside(Color player) {
         state[60] = EMPTY; // old king square
         state[62] = BLACK_KING;
         state[61] = BLACK_ROOK;
+        king_squares[BLACK] = 62;
         black_can_oo = false;
         black_can_ooo = false;
     }
 }
 
 void Board::castle_queenside(Color player) {
+    en_passant_square = -1;
     if (player == WHITE) {
         state[0] = EMPTY; // old rook square
         state[4] = EMPTY; // old king square
         state[2] = WHITE_KING;
         state[3] = WHITE_ROOK;
+        king_squares[WHITE] = 2;
         white_can_oo = false;
         white_can_ooo = false;
     } else {
@@ -1041,6 +1545,7 @@ void Board::castle_queenside(Color player) {
         state[60] = EMPTY; // old king square
         state[58] = BLACK_KING;
         state[59] = BLACK_ROOK;
+        king_squares[BLACK] = 58;
         black_can_oo = false;
         black_can_ooo = false;
     }
@@ -1073,7 +1578,7 @@ void Board::handle_prev_move_history(std::string& notation) {
     }
 }
 
-void Board::handle_castling_history(Piece piece, int src_index) {
+void Board::handle_castling_history(Piece piece, int src_index, int dst_index) {
     if (piece == WHITE_KING) {
         white_can_oo = false;
         white_can_ooo = false;
@@ -1089,6 +1594,17 @@ void Board::handle_castling_history(Piece piece, int src_index) {
     } else if (piece == BLACK_ROOK && src_index == 63) {
         black_can_oo = false;
     }
+
+    // Capturing a rook on its corner takes that side's castling right away too
+    if (dst_index == 0) {
+        white_can_ooo = false;
+    } else if (dst_index == 7) {
+        white_can_oo = false;
+    } else if (dst_index == 56) {
+        black_can_ooo = false;
+    } else if (dst_index == 63) {
+        black_can_oo = false;
+    }
 }
 
 void Board::handle_en_passant_history(Piece piece, int src_rank, int dst_rank, int src_file) {
@@ -1176,7 +1692,10 @@ Board::Board() {
     white_can_ooo = true;
     en_passant_square = -1;
     draw_move_counter = 0;
+    ply_count = 0;
     prev_moves.clear();
+    king_squares[WHITE] = 4;
+    king_squares[BLACK] = 60;
 }
 
 vector<std::string> Board::generate_all_squares() {
@@ -1199,10 +1718,13 @@ Board::Board(const Board& other) {
     std::copy(std::begin(other.state), std::end(other.state), std::begin(state));
     en_passant_square = other.en_passant_square;
     draw_move_counter = other.draw_move_counter;
+    ply_count = other.ply_count;
     black_can_oo = other.black_can_oo;
     black_can_ooo = other.black_can_ooo;
     white_can_oo = other.white_can_oo;
     white_can_ooo = other.white_can_ooo;
+    king_squares[WHITE] = other.king_squares[WHITE];
+    king_squares[BLACK] = other.king_squares[BLACK];
 }
 
 Board::Board(std::string FEN) {
@@ -1269,8 +1791,12 @@ Board::Board(std::string FEN) {
     // Set draw move counter from halfmove clock.
     draw_move_counter = std::stoi(halfmove);
 
+    // Count plies from the fullmove number (1 = first move of the game)
+    ply_count = 2 * (std::stoi(fullmove) - 1) + (activeColor == "b" ? 1 : 0);
+
     // Clear move history.
     prev_moves.clear();
+    locate_kings();
 }
 
 std::wstring get_piece_string(const Piece piece) {
@@ -1,12 +1,14 @@
 #ifndef BOARD_H
 #define BOARD_H
 #include "move.h"
+#include "eval_params.h"
 #include <cstdint>
 #include <vector>
 #include <string>
 using std::vector;
 
 enum Color : uint8_t;
+enum PackedResult : uint8_t;
 
 enum Piece : uint8_t {
     EMPTY,
@@ -26,16 +28,52 @@ enum Piece : uint8_t {
     BLACK_KING,
 };
 
+enum TerminalState : uint8_t {
+    NOT_TERMINAL,
+    CHECKMATED,
+    STALEMATED
+};
+
+struct PackedPosition;
+struct AttackMaps;
+
+// Check and pin information for one side, computed once per position so that pseudo-legal moves can be
+// verified one at a time (see Board::is_pseudo_legal_move_legal)
+struct LegalityInfo {
+    int king_index;
+    bool in_check;
+    uint64_t pinned; // bit per square: pieces pinned against their own king
+};
+
+// What it takes for one side's move to check the enemy king, computed once per position (see Board::gives_check)
+struct CheckInfo {
+    int enemy_king;
+    uint64_t knight_checks; // squares a knight checks from
+    uint64_t pawn_checks;   // squares a pawn checks from
+    uint64_t discoverers;   // own pieces that uncover a slider's check when they leave the line
+};
+
 class Board {
 private:
+    friend PackedPosition pack_position(const Board& board, Color side_to_move, int16_t score, PackedResult result);
+    friend Board unpack_position(const PackedPosition& packed, Color& side_to_move);
+
     vector<Move> prev_moves;
     Piece state[64];
     int en_passant_square;
     int draw_move_counter;
+    int ply_count;
     bool black_can_oo;
     bool black_can_ooo;
     bool white_can_oo;
     bool white_can_ooo;
+    int king_squares[2]; // by color, kept up to date by every move (-1 = no king)
+
+    void locate_kings();
+    // Pieces of 'blocker_color' standing alone between the king on 'king_square' and a slider of 'slider_color'
+    uint64_t line_blockers(int king_square, Color blocker_color, Color slider_color);
+    // First occupied square from 'square' in the given direction, not counting 'skip' (-1 = none)
+    int first_occupied(int square, int step_file, int step_rank, int skip);
 
     static vector<std::string> generate_all_squares();
     inline static vector<std::string> all_squares = generate_all_squares();
@@ -43,6 +81,8 @@ private:
     int get_lowest_piece_index(Piece piece);
 
     bool pinned_move(Color player, int src_index, int dst_index);
+    bool is_en_passant_target(Color player, int dst_index) const;
+    bool has_any_legal_move(Color player, bool in_check);
     bool is_square_under_attack(int file, int rank, Color player);
 
     bool is_under_attack_from_king(int file, int rank, Color player);
@@ -57,7 +97,7 @@ private:
     bool is_queenside_castle_legal(Color player);
     void castle_queenside(Color player);
 
-    void handle_castling_history(Piece piece, int src_index);
+    void handle_castling_history(Piece piece, int src_index, int dst_index);
     void handle_en_passant_history(Piece piece, int src_rank, int dst_rank, int src_file);
     void handle_promotion(Piece piece, std::string& notation, int dst_rank, int dst_index);
     void handle_prev_move_history(std::string& notation);
@@ -69,21 +109,23 @@ private:
     bool is_legal_straight_move(Color player, int src_index, int dst_index);
     bool is_legal_king_move(Color player, int src_index, int dst_index);
     
-    void append_all_legal_pawn_moves(vector<Move>& legal_moves, int src_index, Color player);
-    void append_all_legal_rook_moves(vector<Move>& legal_moves, int src_index, Color player);
-    void append_all_legal_knight_moves(vector<Move>& legal_moves, int src_index, Color player);
-    void append_all_legal_bishop_moves(vector<Move>& legal_moves, int src_index, Color player);
-    void append_all_legal_queen_moves(vector<Move>& legal_moves, int src_index, Color player);
-    void append_all_legal_king_moves(vector<Move>& legal_moves, int src_index, Color player);
-
-    double calculate_raw_material_score();
-    double calculate_mobility_difference();
+    vector<Move> generate_moves(Color player, bool check_pins);
+    void append_all_legal_pawn_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins = true);
+    void append_all_legal_rook_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins = true);
+    void append_all_legal_knight_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins = true);
+    void append_all_legal_bishop_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins = true);
+    void append_all_legal_queen_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins = true);
+    void append_all_legal_king_moves(vector<Move>& legal_moves, int src_index, Color player, bool check_pins = true);
+
+    void build_attack_maps(AttackMaps& maps);
+    void evaluate_attack_maps(EvalFeatures& features);
     double evaluate_king_safety();
     double evaluate_pawn_structure();
 
 public:
     Board();
     Board(const Board& other);
+    Board& operator=(const Board& other) = default;
     Board(std::string FEN);
 
     void display() const;
@@ -93,14 +135,48 @@ public:
     
     bool is_legal_move(const Move& move, Color player);
     bool has_no_legal_moves(Color player);
+    bool has_any_legal_move(Color player);
+    TerminalState get_terminal_state(Color player);
+    TerminalState get_terminal_state(Color player, bool in_check);
     vector<Move> get_legal_moves(Color player);
+
+    // Moves that may still leave the own king in check (castling is always fully checked). Each one must pass
+    // is_pseudo_legal_move_legal before it is played, which is cheap for most moves and only paid for the moves
+    // that actually get searched.
+    vector<Move> get_pseudo_legal_moves(Color player);
+    LegalityInfo get_legality_info(Color player);
+    LegalityInfo get_legality_info(Color player, bool in_check);
+
+    // Whether 'player' playing 'move' checks the other king, without playing it: direct checks come from the
+    // precomputed check squares (or one ray walk for sliders) and discovered checks from the line blockers
+    CheckInfo get_check_info(Color player);
+    bool gives_check(const Move& move, Color player, const CheckInfo& info);
+    bool gives_check(const Move& move, Color player);
+    bool is_pseudo_legal_move_legal(const Move& move, Color player, const LegalityInfo& info);
     
     bool is_checked(Color player);
     bool is_fifty_move_rule_draw();
     bool is_threefold_repetition_draw();
 
+    int get_ply_count() const;
+    int get_draw_move_counter() const;
+    int get_en_passant_square() const;
+    bool has_castling_rights() const;
+    uint64_t get_hash(Color player_to_move);
+    // get_hash of the position after 'player' plays 'move', updated from this position's 'hash' without playing
+    // the move (so its transposition table entry can be prefetched first)
+    uint64_t hash_after_move(uint64_t hash, const Move& move, Color player);
+
     Board inspect_move(Move& move, Color player);
-    double score_position(Color player_to_move, int depth, double material_weight, double king_safety_weight);
+    double score_position(Color player_to_move, int depth, const EvalParams& params);
+    // Same, when it is already known whether 'player_to_move' is in check
+    double score_position(Color player_to_move, int depth, const EvalParams& params, bool in_check);
+    // The mate or draw score when the game is over (true), so callers can supply the evaluation themselves
+    bool score_game_over(Color player_to_move, int depth, bool in_check, double& score);
+
+    // Static evaluation, ignoring mates and draws (white-relative like score_position)
+    double evaluate(const EvalParams& params);
+    EvalFeatures get_eval_features();
 };
 
 std::wstring get_piece_string(const Piece piece);
@@ -0,0 +1,159 @@
+#include "epd.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+bool EpdRecord::has_operation(const std::string& opcode) const {
+    return operations.count(opcode) > 0;
+}
+
+std::string EpdRecord::get_operation(const std::string& opcode) const {
+    auto it = operations.find(opcode);
+    return (it == operations.end()) ? "" : it->second;
+}
+
+static bool is_number(const std::string& token) {
+    if (token.empty()) {
+        return false;
+    }
+    for (char c : token) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+bool parse_epd(const std::string& line, EpdRecord& record) {
+    std::string text = trim(line);
+    if (text.empty() || text[0] == '#') {
+        return false;
+    }
+
+    // Position fields: placement, side to move, castling, en passant
+    std::istringstream stream(text);
+    std::string placement, side, castling, en_passant;
+    if (!(stream >> placement >> side >> castling >> en_passant)) {
+        return false;
+    }
+    if (std::count(placement.begin(), placement.end(), '/') != 7 || (side != "w" && side != "b")) {
+        return false;
+    }
+
+    record = EpdRecord();
+    record.side_to_move = (side == "w") ? WHITE : BLACK;
+
+    std::string rest;
+    std::getline(stream, rest);
+    rest = trim(rest);
+
+    // FEN-style move counters in place of operations
+    std::istringstream counters(rest);
+    std::string halfmove, fullmove;
+    if (counters >> halfmove >> fullmove && is_number(halfmove) && is_number(fullmove)) {
+        record.operations["hmvc"] = halfmove;
+        record.operations["fmvn"] = fullmove;
+        std::getline(counters, rest);
+    }
+
+    // Operations: "opcode operand operand ...;" with operands optionally in double quotes
+    std::string operation;
+    bool in_quotes = false;
+    for (char c : rest + ";") {
+        if (c == '"') {
+            in_quotes = !in_quotes;
+        } else if (c == ';' && !in_quotes) {
+            operation = trim(operation);
+            if (!operation.empty()) {
+                size_t space = operation.find_first_of(" \t");
+                std::string opcode = operation.substr(0, space);
+                std::string operand = (space == std::string::npos) ? "" : trim(operation.substr(space));
+                record.operations[opcode] = operand;
+            }
+            operation.clear();
+        } else {
+            operation += c;
+        }
+    }
+
+    std::string hmvc = record.has_operation("hmvc") ? record.get_operation("hmvc") : "0";
+    std::string fmvn = record.has_operation("fmvn") ? record.get_operation("fmvn") : "1";
+    record.fen = placement + " " + side + " " + castling + " " + en_passant + " " + hmvc + " " + fmvn;
+    return true;
+}
+
+std::vector<EpdRecord> load_epd_file(const std::string& path) {
+    std::vector<EpdRecord> records;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        EpdRecord record;
+        if (parse_epd(line, record)) {
+            records.push_back(record);
+        }
+    }
+    return records;
+}
+
+static bool parse_result(std::string text, double& result) {
+    text.erase(std::remove(text.begin(), text.end(), '"'), text.end());
+    if (text == "1-0" || text == "1" || text == "1.0") { result = 1.0; return true; }
+    if (text == "0-1" || text == "0" || text == "0.0") { result = 0.0; return true; }
+    if (text == "1/2-1/2" || text == "0.5") { result = 0.5; return true; }
+    return false;
+}
+
+bool parse_labelled_position(const std::string& line, std::string& fen, Color& side_to_move, double& result) {
+    std::string position = line;
+    bool has_result = false;
+
+    // "<FEN> [result]"
+    size_t bracket = position.find('[');
+    if (bracket != std::string::npos) {
+        size_t close = position.find(']', bracket);
+        if (close == std::string::npos || !parse_result(position.substr(bracket + 1, close - bracket - 1), result)) {
+            return false;
+        }
+        position = position.substr(0, bracket);
+        has_result = true;
+    }
+
+    // "<FEN> 1-0" (a bare result after the position)
+    if (!has_result) {
+        size_t last_space = position.find_last_of(" \t", position.find_last_not_of(" \t\r\n;"));
+        if (last_space != std::string::npos) {
+            std::string last = position.substr(last_space + 1);
+            last = last.substr(0, last.find_first_of(" \t\r\n;"));
+            if (last.find('-') != std::string::npos && parse_result(last, result)) {
+                position = position.substr(0, last_space);
+                has_result = true;
+            }
+        }
+    }
+
+    EpdRecord record;
+    if (!parse_epd(position, record)) {
+        return false;
+    }
+
+    // "<EPD> c9 "1-0";"
+    if (!has_result) {
+        if (!record.has_operation("c9") || !parse_result(record.get_operation("c9"), result)) {
+            return false;
+        }
+    }
+
+    fen = record.fen;
+    side_to_move = record.side_to_move;
+    return true;
+}
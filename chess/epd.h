@@ -0,0 +1,29 @@
+#ifndef EPD_H
+#define EPD_H
+#include "game.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// One EPD record: the four position fields plus its operations ("bm", "id", "hmvc", ...).
+// Plain FEN lines are accepted too, their move counters become "hmvc"/"fmvn".
+struct EpdRecord {
+    std::string fen; // complete FEN, move counters taken from hmvc/fmvn (0 1 if absent)
+    Color side_to_move;
+    std::map<std::string, std::string> operations; // opcode -> operand(s), quotes removed
+
+    bool has_operation(const std::string& opcode) const;
+    std::string get_operation(const std::string& opcode) const;
+};
+
+// Returns false for blank lines, comments (#) and records with malformed position fields.
+bool parse_epd(const std::string& line, EpdRecord& record);
+
+// Every valid record in the file, in file order (empty if the file can't be read).
+std::vector<EpdRecord> load_epd_file(const std::string& path);
+
+// Splits a labelled dataset line ("<FEN> [1.0]", "<EPD> c9 \"1-0\";", "<FEN> 0-1", ...) into the position and the
+// game result (white's score: 1, 0.5 or 0); false for unusable lines.
+bool parse_labelled_position(const std::string& line, std::string& fen, Color& side_to_move, double& result);
+
+#endif
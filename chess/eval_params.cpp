@@ -0,0 +1,90 @@
+#include "eval_params.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+const std::vector<EvalParamField>& eval_param_fields() {
+    static const std::vector<EvalParamField> fields = {
+        {"material_weight", &EvalParams::material_weight},
+        {"knight_value", &EvalParams::knight_value},
+        {"bishop_value", &EvalParams::bishop_value},
+        {"rook_value", &EvalParams::rook_value},
+        {"queen_value", &EvalParams::queen_value},
+        {"king_safety_weight", &EvalParams::king_safety_weight},
+        {"pawn_structure_weight", &EvalParams::pawn_structure_weight},
+        {"knight_mobility_weight", &EvalParams::knight_mobility_weight},
+        {"bishop_mobility_weight", &EvalParams::bishop_mobility_weight},
+        {"rook_mobility_weight", &EvalParams::rook_mobility_weight},
+        {"queen_mobility_weight", &EvalParams::queen_mobility_weight},
+        {"king_attack_weight", &EvalParams::king_attack_weight},
+        {"pawn_shield_weight", &EvalParams::pawn_shield_weight},
+        {"hanging_piece_weight", &EvalParams::hanging_piece_weight},
+    };
+    return fields;
+}
+
+double evaluate_features(const EvalFeatures& features, const EvalParams& params) {
+    double material = features.pawns
+                    + features.knights * params.knight_value
+                    + features.bishops * params.bishop_value
+                    + features.rooks * params.rook_value
+                    + features.queens * params.queen_value;
+
+    return material * params.material_weight
+         + features.king_safety * params.king_safety_weight
+         + features.pawn_structure * params.pawn_structure_weight
+         + features.knight_mobility * params.knight_mobility_weight
+         + features.bishop_mobility * params.bishop_mobility_weight
+         + features.rook_mobility * params.rook_mobility_weight
+         + features.queen_mobility * params.queen_mobility_weight
+         + features.king_zone_attacks * params.king_attack_weight
+         + features.pawn_shield * params.pawn_shield_weight
+         + features.hanging_pieces * params.hanging_piece_weight;
+}
+
+bool load_eval_params(const std::string& path, EvalParams& params) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream stream(line);
+        std::string name;
+        double value;
+        if (!(stream >> name)) {
+            continue; // blank line or comment
+        }
+        if (!(stream >> value)) {
+            return false;
+        }
+
+        bool known = false;
+        for (const EvalParamField& field : eval_param_fields()) {
+            if (name == field.name) {
+                params.*field.value = value;
+                known = true;
+            }
+        }
+        if (!known) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool save_eval_params(const std::string& path, const EvalParams& params) {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    file << "# Pawn Cena evaluation parameters" << std::endl;
+    file << std::setprecision(6) << std::fixed;
+    for (const EvalParamField& field : eval_param_fields()) {
+        file << field.name << " " << params.*field.value << std::endl;
+    }
+    return static_cast<bool>(file);
+}
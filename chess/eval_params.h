@@ -0,0 +1,56 @@
+#ifndef EVAL_PARAMS_H
+#define EVAL_PARAMS_H
+#include <string>
+#include <vector>
+
+// Weights of the static evaluation. Material is counted in pawns (a pawn is always 1.0) and scaled by
+// material_weight; the defaults are the hand-picked values the bot plays with.
+struct EvalParams {
+    double material_weight = 20.0;
+    double knight_value = 3.0;
+    double bishop_value = 3.0;
+    double rook_value = 5.0;
+    double queen_value = 9.0;
+    double king_safety_weight = 1.0;
+    double pawn_structure_weight = 0.0;
+
+    // Attack-map terms, per square or piece (material_weight doesn't apply)
+    double knight_mobility_weight = 1.0;
+    double bishop_mobility_weight = 1.0;
+    double rook_mobility_weight = 0.5;
+    double queen_mobility_weight = 0.25;
+    double king_attack_weight = 1.0;
+    double pawn_shield_weight = 2.0;
+    double hanging_piece_weight = 2.0;
+};
+
+// Name and location of every parameter, in parameter file order (used for loading, saving and tuning)
+struct EvalParamField {
+    const char* name;
+    double EvalParams::* value;
+};
+const std::vector<EvalParamField>& eval_param_fields();
+
+// The white-relative terms the evaluation combines, so a position can be re-scored under different
+// parameters without the board (see bot/tuner.cpp).
+struct EvalFeatures {
+    int pawns, knights, bishops, rooks, queens; // white count minus black count
+    double king_safety;
+    double pawn_structure;
+
+    // From the attack maps, white minus black: safe squares attacked per piece type (mobility), attacked squares
+    // around the enemy king, pawns shielding the own king and undefended pieces under attack (counted for the
+    // side they hurt, so a white hanging piece is negative)
+    int knight_mobility, bishop_mobility, rook_mobility, queen_mobility;
+    int king_zone_attacks;
+    int pawn_shield;
+    int hanging_pieces;
+};
+double evaluate_features(const EvalFeatures& features, const EvalParams& params);
+
+// Parameter files hold one "name value" pair per line ('#' starts a comment). Parameters missing from the file
+// keep their current value; returns false if the file can't be read or names an unknown parameter.
+bool load_eval_params(const std::string& path, EvalParams& params);
+bool save_eval_params(const std::string& path, const EvalParams& params);
+
+#endif
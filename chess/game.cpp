@@ -6,71 +6,102 @@
 #include "game.h"
 #include "move.h"
 #include "gui.h"
+#include "notation.h"
+#include "pgn.h"
+#include <ctime>
 using std::cout, std::endl;
 
+// Every game played through play_game is appended here
+static const std::string GAMES_PGN_PATH = "games.pgn";
+
+static std::string pgn_date() {
+    std::time_t now = std::time(nullptr);
+    char date[16];
+    std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+    return date;
+}
+
+static Color end_game(Board& board, PgnGame& pgn, Color result) {
+    board.display();
+    pgn.result = result_to_pgn(result);
+    if (!append_pgn(GAMES_PGN_PATH, pgn)) {
+        debug_log("Failed to save game to " + GAMES_PGN_PATH);
+    }
+    return result;
+}
+
 Color play_game(bool white_real, bool black_real) {
 
     Board board;
     board.display();
 
+    PgnGame pgn;
+    pgn.set_tag("Event", "Pawn Cena game");
+    pgn.set_tag("Site", "?");
+    pgn.set_tag("Date", pgn_date());
+    pgn.set_tag("Round", "-");
+    pgn.set_tag("White", white_real ? "Human" : "Pawn Cena");
+    pgn.set_tag("Black", black_real ? "Human" : "Pawn Cena");
+
+    Bot white_bot(5);
+    Bot black_bot(5);
+    configure_game_bot(white_bot);
+    configure_game_bot(black_bot);
+
     while (true) {
 
         /////////////////////////////////////////
         ///////////////// WHITE /////////////////
         /////////////////////////////////////////
-        play_move(board, WHITE, white_real);
-
-        // See if black is checkmated
-        if (is_checkmated(board, BLACK)) {
-            board.display();
-            return WHITE;
+        Board board_before_move = board;
+        Move move = play_move(board, WHITE, white_real, white_bot);
+        pgn.moves.push_back(move_to_san(board_before_move, move, WHITE));
+
+        // See if black is checkmated or a stalemate exists
+        TerminalState black_state = board.get_terminal_state(BLACK);
+        if (black_state == CHECKMATED) {
+            return end_game(board, pgn, WHITE);
         }
         
-        // See if a stalemate exists
-        if (is_stalemated(board, BLACK)) {
-            board.display();
-            return DRAW;
+        if (black_state == STALEMATED) {
+            return end_game(board, pgn, DRAW);
         }
 
         // Check for fifty move rule draws
         if (fifty_move_rule_draw(board)) {
-            board.display();
-            return DRAW;
+            return end_game(board, pgn, DRAW);
         }
     
         // Check for threefold repetition rule draws
         if (threefold_repetition_draw(board)) {
-            board.display();
-            return DRAW;
+            return end_game(board, pgn, DRAW);
         } 
 
         /////////////////////////////////////////
         ///////////////// BLACK /////////////////
         /////////////////////////////////////////
-        play_move(board, BLACK, black_real);
-
-        // See if white is checkmated
-        if (is_checkmated(board, WHITE)) {
-            board.display();
-            return BLACK;
+        board_before_move = board;
+        move = play_move(board, BLACK, black_real, black_bot);
+        pgn.moves.push_back(move_to_san(board_before_move, move, BLACK));
+
+        // See if white is checkmated or a stalemate exists
+        TerminalState white_state = board.get_terminal_state(WHITE);
+        if (white_state == CHECKMATED) {
+            return end_game(board, pgn, BLACK);
         }
         
-        // See if a stalemate exists
-        if (is_stalemated(board, WHITE)) {
-            board.display();
-            return DRAW;
+        if (white_state == STALEMATED) {
+            return end_game(board, pgn, DRAW);
         }
 
         // Check for fifty move rule draws
         if (fifty_move_rule_draw(board)) {
-            board.display();
-            return DRAW;
+            return end_game(board, pgn, DRAW);
         }
     
         // Check for threefold repetition rule draws
         if (threefold_repetition_draw(board)) {
-            board.display();
-            return DRAW;
+            return end_game(board, pgn, DRAW);
         } 
 
     }
@@ -78,8 +109,35 @@ Color play_game(bool white_real, bool black_real) {
     return DRAW;
 }
 
+Color play_bot_game(Board& board, Color player, Bot& white_bot, Bot& black_bot, int max_plies, PgnGame* pgn) {
+    Color result = DRAW;
+    for (int ply = 0; ply < max_plies; ply++) {
+        TerminalState state = board.get_terminal_state(player);
+        if (state == CHECKMATED) {
+            result = (player == WHITE) ? BLACK : WHITE;
+            break;
+        }
+        if (state == STALEMATED || fifty_move_rule_draw(board) || threefold_repetition_draw(board)) {
+            break;
+        }
+
+        Bot& bot = (player == WHITE) ? white_bot : black_bot;
+        Move move = bot.request_move(board, player);
+        if (pgn != nullptr) {
+            pgn->moves.push_back(move_to_san(board, move, player));
+        }
+        board.update_move(move, player);
+        player = (player == WHITE) ? BLACK : WHITE;
+    }
+
+    if (pgn != nullptr) {
+        pgn->result = result_to_pgn(result);
+    }
+    return result;
+}
+
 // NOTE: This function assumes at least 1 legal move can be played by 'player'!
-void play_move(Board& board, Color player, bool is_real) {
+Move play_move(Board& board, Color player, bool is_real, Bot& bot) {
 
     // Request the move to be played
     Move move;
@@ -87,7 +145,7 @@ void play_move(Board& board, Color player, bool is_real) {
         board.display();
         move.set_move(request_player_move(board, player));
     } else {
-        move = request_bot_move(board, player);
+        move = request_bot_move(board, player, bot);
     }
 
     // Update the board
@@ -96,16 +154,41 @@ void play_move(Board& board, Color player, bool is_real) {
     if (is_real) {
         board.display();
     }
+
+    return move;
+}
+
+void configure_game_bot(Bot& bot) {
+    // The book is mapped once and shared by every bot (missing book file = no book moves)
+    static OpeningBook book("book.bin");
+
+    // Tuned evaluation weights (missing file = the built-in weights)
+    static const EvalParams eval_params = [] {
+        EvalParams params;
+        load_eval_params("eval.params", params);
+        return params;
+    }();
+
+    bot.set_eval_params(eval_params);
+    bot.set_opening_book(&book, 16, BOOK_WEIGHTED_RANDOM);
 }
 
 Move request_bot_move(Board& board, Color player) {
-    Bot bot(5, 20.0, 1.0);
+    Bot bot(5);
+    configure_game_bot(bot);
+    return request_bot_move(board, player, bot);
+}
 
+Move request_bot_move(Board& board, Color player, Bot& bot) {
     std::string text = "Pawn Cena is selecting move...";
     write_gui_box(text);
 
     Move move = bot.request_move(board, player);
 
+#ifdef SEARCH_STATS
+    debug_log(bot.get_search_stats().to_json());
+#endif
+
     std::string player_color = (player == WHITE) ? "white" : "black";
     text = "Pawn Cena (" + player_color + ") plays " + move.get_move() + ".";
     write_gui_box(text);
@@ -114,11 +197,11 @@ Move request_bot_move(Board& board, Color player) {
 }
 
 bool is_checkmated(Board& board, Color player) {
-    return board.is_checked(player) && board.has_no_legal_moves(player);
+    return board.get_terminal_state(player) == CHECKMATED;
 }
 
 bool is_stalemated(Board& board, Color player) {
-    return !board.is_checked(player) && board.has_no_legal_moves(player);
+    return board.get_terminal_state(player) == STALEMATED;
 }
 
 bool fifty_move_rule_draw(Board& board) {
@@ -4,16 +4,31 @@
 #include <string>
 #include <cstdint>
 
+class Bot;
+struct PgnGame;
+
 enum Color : uint8_t {
     WHITE,
     BLACK,
     DRAW
 };
 
+// The engine side(s) keep one Bot for the whole game, so its transposition table, killers and history carry
+// over from move to move.
 Color play_game(bool white_real, bool black_real);
 
-void play_move(Board& board, Color player, bool is_real);
+// Headless bot-vs-bot game from 'board' with 'player' to move. Games still running after 'max_plies' are
+// scored as draws. The moves and result are added to 'pgn' if given.
+Color play_bot_game(Board& board, Color player, Bot& white_bot, Bot& black_bot, int max_plies, PgnGame* pgn = nullptr);
+
+Move play_move(Board& board, Color player, bool is_real, Bot& bot);
+
+// Sets up 'bot' the way games use it: depth 5, the tuned weights from eval.params and the opening book
+void configure_game_bot(Bot& bot);
+
+Move request_bot_move(Board& board, Color player, Bot& bot);
 
+// One-off move from a freshly configured bot (nothing carries over to the next call)
 Move request_bot_move(Board& board, Color player);
 
 bool is_checkmated(Board& board, Color player);
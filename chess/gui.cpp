@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <cstdlib>
+#include <cassert>
 #include <iostream>
 #include "game.h"
 #include "board.h"
@@ -0,0 +1,118 @@
+#include "notation.h"
+#include <algorithm>
+
+static char san_piece_letter(Piece piece) {
+    switch (piece) {
+        case WHITE_KNIGHT: case BLACK_KNIGHT: return 'N';
+        case WHITE_BISHOP: case BLACK_BISHOP: return 'B';
+        case WHITE_ROOK: case BLACK_ROOK: return 'R';
+        case WHITE_QUEEN: case BLACK_QUEEN: return 'Q';
+        case WHITE_KING: case BLACK_KING: return 'K';
+        default: return '\0';
+    }
+}
+
+// SAN without the check/mate suffix
+static std::string san_body(Board& board, const std::string& notation, Color player, const vector<Move>& legal_moves) {
+    if (notation == "oo") {
+        return "O-O";
+    }
+    if (notation == "ooo") {
+        return "O-O-O";
+    }
+
+    int src_file = notation[0] - 'a', src_rank = notation[1] - '1';
+    int dst_file = notation[2] - 'a', dst_rank = notation[3] - '1';
+    Piece piece = board.get_piece(src_file, src_rank);
+    bool is_pawn = (piece == WHITE_PAWN || piece == BLACK_PAWN);
+    bool is_capture = board.get_piece(dst_file, dst_rank) != EMPTY || (is_pawn && src_file != dst_file);
+    std::string destination = notation.substr(2, 2);
+
+    if (is_pawn) {
+        std::string san = is_capture ? std::string(1, notation[0]) + "x" + destination : destination;
+        int back_rank = (player == WHITE) ? 7 : 0;
+        if (notation.size() > 4) {
+            san += "=" + std::string(1, notation[5]);
+        } else if (dst_rank == back_rank) {
+            san += "=Q";
+        }
+        return san;
+    }
+
+    // Disambiguate between identical pieces that can reach the same square: file first, then rank, then both
+    bool ambiguous = false, same_file = false, same_rank = false;
+    for (const Move& other : legal_moves) {
+        std::string other_notation = other.get_move();
+        if (other_notation.size() < 4 || other_notation == notation || other_notation.substr(2, 2) != destination) {
+            continue;
+        }
+        if (board.get_piece(other_notation[0] - 'a', other_notation[1] - '1') != piece) {
+            continue;
+        }
+        ambiguous = true;
+        same_file = same_file || other_notation[0] == notation[0];
+        same_rank = same_rank || other_notation[1] == notation[1];
+    }
+
+    std::string san(1, san_piece_letter(piece));
+    if (ambiguous) {
+        if (!same_file) {
+            san += notation[0];
+        } else if (!same_rank) {
+            san += notation[1];
+        } else {
+            san += notation.substr(0, 2);
+        }
+    }
+    if (is_capture) {
+        san += "x";
+    }
+    return san + destination;
+}
+
+std::string move_to_san(Board& board, const Move& move, Color player) {
+    vector<Move> legal_moves = board.get_legal_moves(player);
+    std::string san = san_body(board, move.get_move(), player, legal_moves);
+
+    Board board_after_move = board;
+    board_after_move.update_move(move, player);
+    Color opponent = (player == WHITE) ? BLACK : WHITE;
+    TerminalState state = board_after_move.get_terminal_state(opponent);
+    if (state == CHECKMATED) {
+        san += "#";
+    } else if (board_after_move.is_checked(opponent)) {
+        san += "+";
+    }
+    return san;
+}
+
+bool san_to_move(Board& board, const std::string& san, Color player, Move& move) {
+    // Strip check marks and annotations ("Nf3+!?"), accept zeros in castling and promotions without '='
+    std::string wanted = san;
+    while (!wanted.empty() && std::string("+#!?").find(wanted.back()) != std::string::npos) {
+        wanted.pop_back();
+    }
+    std::replace(wanted.begin(), wanted.end(), '0', 'O');
+    wanted.erase(std::remove(wanted.begin(), wanted.end(), '='), wanted.end());
+
+    vector<Move> legal_moves = board.get_legal_moves(player);
+    int matches = 0;
+    for (const Move& candidate : legal_moves) {
+        std::string candidate_san = san_body(board, candidate.get_move(), player, legal_moves);
+        candidate_san.erase(std::remove(candidate_san.begin(), candidate_san.end(), '='), candidate_san.end());
+
+        // Over-specified SAN ("Ngf3" with only one knight able to go there) still names the move
+        bool match = candidate_san == wanted;
+        if (!match && wanted.size() == candidate_san.size() + 1 && wanted.size() >= 3) {
+            std::string notation = candidate.get_move();
+            char hint = wanted[1];
+            std::string without_hint = wanted.substr(0, 1) + wanted.substr(2);
+            match = without_hint == candidate_san && (hint == notation[0] || hint == notation[1]);
+        }
+        if (match) {
+            move = candidate;
+            matches++;
+        }
+    }
+    return matches == 1;
+}
@@ -0,0 +1,14 @@
+#ifndef NOTATION_H
+#define NOTATION_H
+#include "board.h"
+#include "game.h"
+#include <string>
+
+// Standard algebraic notation ("Nbd7", "exd5", "e8=Q+", "O-O#") for a legal 'move' by 'player'.
+std::string move_to_san(Board& board, const Move& move, Color player);
+
+// Finds the legal move 'san' names. Check/annotation suffixes are optional and "0-0" is accepted for "O-O".
+// Returns false if no legal move (or more than one) matches.
+bool san_to_move(Board& board, const std::string& san, Color player, Move& move);
+
+#endif
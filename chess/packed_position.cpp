@@ -0,0 +1,225 @@
+#include "packed_position.h"
+#include "epd.h"
+#include "pgn.h"
+#include "notation.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+PackedPosition pack_position(const Board& board, Color side_to_move, int16_t score, PackedResult result) {
+    PackedPosition packed;
+    std::memset(&packed, 0, sizeof(packed));
+
+    int piece_count = 0;
+    for (int square = 0; square < 64 && piece_count < 32; square++) {
+        Piece piece = board.state[square];
+        if (piece == EMPTY) {
+            continue;
+        }
+        packed.occupancy |= 1ULL << square;
+        packed.pieces[piece_count / 2] |= piece << (4 * (piece_count % 2));
+        piece_count++;
+    }
+
+    packed.score = score;
+    packed.fullmove = board.ply_count / 2 + 1;
+    packed.flags = (side_to_move == BLACK ? 1 : 0)
+                 | (board.white_can_oo ? 2 : 0)
+                 | (board.white_can_ooo ? 4 : 0)
+                 | (board.black_can_oo ? 8 : 0)
+                 | (board.black_can_ooo ? 16 : 0);
+    packed.en_passant = (board.en_passant_square < 0) ? 64 : board.en_passant_square;
+    packed.halfmove = std::min(board.draw_move_counter, 255);
+    packed.result = result;
+    return packed;
+}
+
+Board unpack_position(const PackedPosition& packed, Color& side_to_move) {
+    Board board;
+    std::fill(std::begin(board.state), std::end(board.state), EMPTY);
+
+    uint64_t occupancy = packed.occupancy;
+    for (int piece_count = 0; occupancy != 0; piece_count++) {
+        int square = __builtin_ctzll(occupancy);
+        occupancy &= occupancy - 1;
+        board.state[square] = static_cast<Piece>((packed.pieces[piece_count / 2] >> (4 * (piece_count % 2))) & 0xF);
+    }
+
+    side_to_move = (packed.flags & 1) ? BLACK : WHITE;
+    board.white_can_oo = packed.flags & 2;
+    board.white_can_ooo = packed.flags & 4;
+    board.black_can_oo = packed.flags & 8;
+    board.black_can_ooo = packed.flags & 16;
+    board.en_passant_square = (packed.en_passant >= 64) ? -1 : packed.en_passant;
+    board.draw_move_counter = packed.halfmove;
+    board.ply_count = 2 * (std::max<int>(packed.fullmove, 1) - 1) + (side_to_move == BLACK ? 1 : 0);
+    board.locate_kings();
+    return board;
+}
+
+PackedPositionFile::PackedPositionFile() : records(nullptr), num_records(0), mapped_size(0) {}
+
+PackedPositionFile::PackedPositionFile(const std::string& path) : records(nullptr), num_records(0), mapped_size(0) {
+    open(path);
+}
+
+PackedPositionFile::~PackedPositionFile() {
+    close();
+}
+
+bool PackedPositionFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t) sizeof(PackedPosition)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    // Datasets are read front to back, so let the kernel read ahead aggressively
+    madvise(mapping, file_stat.st_size, MADV_SEQUENTIAL);
+
+    records = static_cast<const PackedPosition*>(mapping);
+    mapped_size = file_stat.st_size;
+    num_records = mapped_size / sizeof(PackedPosition);
+    return true;
+}
+
+void PackedPositionFile::close() {
+    if (records != nullptr) {
+        munmap(const_cast<PackedPosition*>(records), mapped_size);
+    }
+    records = nullptr;
+    num_records = 0;
+    mapped_size = 0;
+}
+
+bool PackedPositionFile::is_open() const {
+    return records != nullptr;
+}
+
+size_t PackedPositionFile::size() const {
+    return num_records;
+}
+
+const PackedPosition& PackedPositionFile::operator[](size_t index) const {
+    return records[index];
+}
+
+Board PackedPositionFile::board(size_t index, Color& side_to_move) const {
+    return unpack_position(records[index], side_to_move);
+}
+
+static PackedResult packed_result(const std::string& pgn_result) {
+    if (pgn_result == "1-0") { return PACKED_WHITE_WIN; }
+    if (pgn_result == "0-1") { return PACKED_BLACK_WIN; }
+    if (pgn_result == "1/2-1/2") { return PACKED_DRAW; }
+    return PACKED_NO_RESULT;
+}
+
+static bool ends_with(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+long convert_to_packed(const std::string& input, const std::string& output) {
+    std::ofstream out(output, std::ios::binary | std::ios::app);
+    if (!out) {
+        return -1;
+    }
+
+    std::vector<PackedPosition> batch;
+    long written = 0;
+    auto flush = [&]() {
+        out.write(reinterpret_cast<const char*>(batch.data()), batch.size() * sizeof(PackedPosition));
+        written += batch.size();
+        batch.clear();
+    };
+
+    if (ends_with(input, ".pgn")) {
+        PgnReader reader(input);
+        if (!reader.is_open()) {
+            return -1;
+        }
+        PgnGame game;
+        while (reader.next(game)) {
+            PackedResult result = packed_result(game.result);
+            std::string fen = game.get_tag("FEN");
+            Board board = fen.empty() ? Board() : Board(fen);
+            Color player = (!fen.empty() && fen.find(" b ") != std::string::npos) ? BLACK : WHITE;
+
+            // Every position before a move, plus the final one if the whole game could be replayed
+            bool complete = true;
+            for (const std::string& san : game.moves) {
+                batch.push_back(pack_position(board, player, 0, result));
+                Move move;
+                if (!san_to_move(board, san, player, move)) {
+                    complete = false;
+                    break;
+                }
+                board.update_move(move, player);
+                player = (player == WHITE) ? BLACK : WHITE;
+            }
+            if (complete) {
+                batch.push_back(pack_position(board, player, 0, result));
+            }
+            if (batch.size() >= 4096) {
+                flush();
+            }
+        }
+    } else {
+        std::ifstream file(input);
+        if (!file) {
+            return -1;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            std::string fen;
+            Color side_to_move;
+            double result_score;
+            PackedResult result = PACKED_NO_RESULT;
+            if (parse_labelled_position(line, fen, side_to_move, result_score)) {
+                result = (result_score == 1.0) ? PACKED_WHITE_WIN : (result_score == 0.0) ? PACKED_BLACK_WIN : PACKED_DRAW;
+            }
+
+            EpdRecord record;
+            if (!parse_epd(line.substr(0, line.find('[')), record)) {
+                continue;
+            }
+
+            // EPD "ce" is in centipawns from the side to move's point of view
+            int16_t score = 0;
+            if (record.has_operation("ce")) {
+                int centipawns = std::atoi(record.get_operation("ce").c_str());
+                centipawns = std::max(-32767, std::min(32767, centipawns));
+                score = (record.side_to_move == WHITE) ? centipawns : -centipawns;
+            }
+
+            Board board(record.fen);
+            batch.push_back(pack_position(board, record.side_to_move, score, result));
+            if (batch.size() >= 4096) {
+                flush();
+            }
+        }
+    }
+
+    flush();
+    return out ? written : -1;
+}
@@ -0,0 +1,63 @@
+#ifndef PACKED_POSITION_H
+#define PACKED_POSITION_H
+#include "board.h"
+#include "game.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum PackedResult : uint8_t {
+    PACKED_BLACK_WIN,
+    PACKED_DRAW,
+    PACKED_WHITE_WIN,
+    PACKED_NO_RESULT = 255
+};
+
+// Fixed-size 32-byte position record for training and tuning datasets. Pieces are stored one nibble per
+// occupied square (Piece values, in square order A1..H8), so reading one back is a few bit operations instead
+// of a FEN parse. Files are arrays of these records in host (little-endian) byte order.
+struct PackedPosition {
+    uint64_t occupancy;      // bit i set = square i occupied (A1 = 0)
+    uint8_t pieces[16];      // up to 32 pieces, low nibble first
+    int16_t score;           // search score, white-relative, in hundredths of a pawn (0 if unknown)
+    uint16_t fullmove;
+    uint8_t flags;           // bit 0: black to move, bits 1-4: castling rights (white OO, white OOO, black OO, black OOO)
+    uint8_t en_passant;      // target square, or 64 for none
+    uint8_t halfmove;        // fifty-move rule counter (saturates at 255)
+    uint8_t result;          // PackedResult
+};
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must stay 32 bytes");
+
+PackedPosition pack_position(const Board& board, Color side_to_move, int16_t score, PackedResult result);
+Board unpack_position(const PackedPosition& packed, Color& side_to_move);
+
+// Read-only, memory-mapped file of PackedPosition records.
+class PackedPositionFile {
+private:
+    const PackedPosition* records;
+    size_t num_records;
+    size_t mapped_size;
+
+public:
+    PackedPositionFile();
+    PackedPositionFile(const std::string& path);
+    ~PackedPositionFile();
+
+    PackedPositionFile(const PackedPositionFile&) = delete;
+    PackedPositionFile& operator=(const PackedPositionFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const;
+    size_t size() const;
+
+    const PackedPosition& operator[](size_t index) const;
+    Board board(size_t index, Color& side_to_move) const;
+};
+
+// Converts FEN/EPD lines (with optional results, see parse_labelled_position, and "ce" scores) or PGN games (every
+// position, labelled with the game result) into packed records appended to 'output'. The input format is picked
+// by extension (.pgn, anything else is read as lines). Returns the number of records written, or -1 on I/O failure.
+long convert_to_packed(const std::string& input, const std::string& output);
+
+#endif
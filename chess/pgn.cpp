@@ -0,0 +1,302 @@
+#include "pgn.h"
+#include "notation.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+
+static const size_t READ_BUFFER_SIZE = 1 << 20;
+
+std::string PgnGame::get_tag(const std::string& name) const {
+    for (const auto& tag : tags) {
+        if (tag.first == name) {
+            return tag.second;
+        }
+    }
+    return "";
+}
+
+void PgnGame::set_tag(const std::string& name, const std::string& value) {
+    for (auto& tag : tags) {
+        if (tag.first == name) {
+            tag.second = value;
+            return;
+        }
+    }
+    tags.push_back({name, value});
+}
+
+std::string result_to_pgn(Color winner) {
+    if (winner == WHITE) { return "1-0"; }
+    if (winner == BLACK) { return "0-1"; }
+    return "1/2-1/2";
+}
+
+static std::string escape_tag_value(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+std::string format_pgn(const PgnGame& game) {
+    std::string text;
+
+    // Seven tag roster in its standard order, then everything else
+    static const char* roster[] = {"Event", "Site", "Date", "Round", "White", "Black", "Result"};
+    for (const char* name : roster) {
+        std::string value = (std::string(name) == "Result") ? game.result : game.get_tag(name);
+        text += "[" + std::string(name) + " \"" + escape_tag_value(value.empty() ? "?" : value) + "\"]\n";
+    }
+    for (const auto& tag : game.tags) {
+        bool in_roster = false;
+        for (const char* name : roster) {
+            in_roster = in_roster || tag.first == name;
+        }
+        if (!in_roster) {
+            text += "[" + tag.first + " \"" + escape_tag_value(tag.second) + "\"]\n";
+        }
+    }
+    text += "\n";
+
+    // Games from a FEN with black to move start with "N..."
+    std::string fen = game.get_tag("FEN");
+    bool black_first = false;
+    int move_number = 1;
+    if (!fen.empty()) {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        while (start < fen.size()) {
+            size_t end = fen.find(' ', start);
+            fields.push_back(fen.substr(start, end - start));
+            start = (end == std::string::npos) ? fen.size() : end + 1;
+        }
+        black_first = fields.size() > 1 && fields[1] == "b";
+        if (fields.size() > 5) {
+            move_number = std::max(1, std::atoi(fields[5].c_str()));
+        }
+    }
+
+    std::string line;
+    auto add_token = [&](const std::string& token) {
+        if (!line.empty() && line.size() + 1 + token.size() > 80) {
+            text += line + "\n";
+            line.clear();
+        }
+        line += (line.empty() ? "" : " ") + token;
+    };
+
+    for (size_t i = 0; i < game.moves.size(); i++) {
+        bool white_move = (i % 2 == 0) != black_first;
+        if (white_move) {
+            add_token(std::to_string(move_number) + ".");
+        } else if (i == 0) {
+            add_token(std::to_string(move_number) + "...");
+        }
+        add_token(game.moves[i]);
+        if (!white_move) {
+            move_number++;
+        }
+    }
+    add_token(game.result);
+    text += line + "\n\n";
+    return text;
+}
+
+bool append_pgn(const std::string& path, const PgnGame& game) {
+    std::ofstream file(path, std::ios::app);
+    file << format_pgn(game);
+    return static_cast<bool>(file);
+}
+
+PgnReader::PgnReader(const std::string& path) : fd(-1), buffer(READ_BUFFER_SIZE), position(0), length(0) {
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+}
+
+PgnReader::~PgnReader() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+bool PgnReader::is_open() const {
+    return fd >= 0;
+}
+
+int PgnReader::peek_char() {
+    if (position == length) {
+        if (fd < 0) {
+            return EOF;
+        }
+        ssize_t bytes = ::read(fd, buffer.data(), buffer.size());
+        if (bytes <= 0) {
+            return EOF;
+        }
+        position = 0;
+        length = bytes;
+    }
+    return static_cast<unsigned char>(buffer[position]);
+}
+
+int PgnReader::next_char() {
+    int c = peek_char();
+    if (c != EOF) {
+        position++;
+    }
+    return c;
+}
+
+void PgnReader::skip_line() {
+    int c;
+    while ((c = next_char()) != EOF && c != '\n') {}
+}
+
+static bool is_result_token(const std::string& token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+bool PgnReader::next(PgnGame& game) {
+    game = PgnGame();
+    bool found_anything = false;
+    bool in_movetext = false;
+    bool at_line_start = true;
+
+    while (true) {
+        int c = peek_char();
+        if (c == EOF) {
+            break;
+        }
+
+        if (c == '\n') {
+            next_char();
+            at_line_start = true;
+            continue;
+        }
+        if (std::isspace(c)) {
+            next_char();
+            continue;
+        }
+
+        // "%" escape lines are ignored
+        if (c == '%' && at_line_start) {
+            skip_line();
+            continue;
+        }
+        at_line_start = false;
+
+        if (c == '[') {
+            // A tag after movetext means the previous game had no result token
+            if (in_movetext) {
+                break;
+            }
+            next_char();
+            std::string name, value;
+            while ((c = next_char()) != EOF && !std::isspace(c) && c != ']') {
+                name += c;
+            }
+            while ((c = next_char()) != EOF && c != '"' && c != ']') {}
+            if (c == '"') {
+                while ((c = next_char()) != EOF && c != '"') {
+                    if (c == '\\') {
+                        c = next_char();
+                    }
+                    value += c;
+                }
+                while ((c = next_char()) != EOF && c != ']') {}
+            }
+            game.set_tag(name, value);
+            found_anything = true;
+            continue;
+        }
+
+        in_movetext = true;
+        found_anything = true;
+        if (c == '{') {
+            while ((c = next_char()) != EOF && c != '}') {}
+            continue;
+        }
+        if (c == ';') {
+            skip_line();
+            at_line_start = true;
+            continue;
+        }
+        if (c == '(') {
+            // Variations can nest and contain comments
+            int variation_depth = 0;
+            while ((c = next_char()) != EOF) {
+                if (c == '{') {
+                    while ((c = next_char()) != EOF && c != '}') {}
+                } else if (c == '(') {
+                    variation_depth++;
+                } else if (c == ')' && --variation_depth == 0) {
+                    break;
+                }
+            }
+            continue;
+        }
+
+        std::string token;
+        while ((c = peek_char()) != EOF && !std::isspace(c) && std::string("{}();[").find(c) == std::string::npos) {
+            token += next_char();
+        }
+        if (token.empty()) {
+            next_char(); // stray ')' or '}'
+            continue;
+        }
+        if (token[0] == '$') {
+            continue; // NAG
+        }
+        if (is_result_token(token)) {
+            game.result = token;
+            return true;
+        }
+
+        // Drop move numbers ("12.", "12...", "12.e4"): digits only count as one when a '.' follows, so castling
+        // written with zeros ("0-0", "0-0-0") is kept whole
+        size_t move_start = token.find_first_not_of("0123456789");
+        if (move_start == std::string::npos) {
+            continue;
+        }
+        if (token[move_start] == '.') {
+            move_start = token.find_first_not_of('.', move_start);
+            if (move_start == std::string::npos) {
+                continue;
+            }
+        } else {
+            move_start = 0;
+        }
+        game.moves.push_back(token.substr(move_start));
+    }
+
+    if (game.result == "*" && !game.get_tag("Result").empty()) {
+        game.result = game.get_tag("Result");
+    }
+    return found_anything;
+}
+
+bool replay_pgn_game(const PgnGame& game, Board& board, Color& player, std::vector<Move>& moves) {
+    std::string fen = game.get_tag("FEN");
+    board = fen.empty() ? Board() : Board(fen);
+    player = (!fen.empty() && fen.find(" b ") != std::string::npos) ? BLACK : WHITE;
+    moves.clear();
+
+    for (const std::string& san : game.moves) {
+        Move move;
+        if (!san_to_move(board, san, player, move)) {
+            return false;
+        }
+        board.update_move(move, player);
+        moves.push_back(move);
+        player = (player == WHITE) ? BLACK : WHITE;
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef PGN_H
+#define PGN_H
+#include "board.h"
+#include "game.h"
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct PgnGame {
+    std::vector<std::pair<std::string, std::string>> tags; // in file order
+    std::vector<std::string> moves;                          // SAN, without move numbers, comments or variations
+    std::string result = "*";                                // "1-0", "0-1", "1/2-1/2" or "*"
+
+    std::string get_tag(const std::string& name) const;
+    void set_tag(const std::string& name, const std::string& value);
+};
+
+// Export format: tags (the seven tag roster first), then numbered movetext wrapped at 80 columns.
+std::string format_pgn(const PgnGame& game);
+bool append_pgn(const std::string& path, const PgnGame& game);
+
+std::string result_to_pgn(Color winner);
+
+// Reads games one at a time through a fixed-size buffer, so databases larger than memory can be streamed.
+// Comments, NAGs, variations and escape lines are skipped.
+class PgnReader {
+private:
+    int fd;
+    std::vector<char> buffer;
+    size_t position;
+    size_t length;
+
+    int peek_char();
+    int next_char();
+    void skip_line();
+
+public:
+    PgnReader(const std::string& path);
+    ~PgnReader();
+
+    PgnReader(const PgnReader&) = delete;
+    PgnReader& operator=(const PgnReader&) = delete;
+
+    bool is_open() const;
+
+    // Returns false once the file is exhausted.
+    bool next(PgnGame& game);
+};
+
+// Plays the game's moves from its FEN tag (or the start position). 'moves' receives every move that could be
+// played; returns false if a move was illegal or unreadable.
+bool replay_pgn_game(const PgnGame& game, Board& board, Color& player, std::vector<Move>& moves);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+#include "board.h"
+#include <array>
+#include <cstdint>
+
+// Random keys for hashing positions. The keys are the standard Polyglot "Random64" table (768 piece/square keys,
+// 4 castling keys, 8 en passant file keys, 1 side to move key), so a position hash is also the key used to look
+// positions up in any Polyglot opening book.
+class Zobrist {
+private:
+    static const int NUM_KEYS = 781;
+    static const int CASTLING_OFFSET = 768;
+    static const int EN_PASSANT_OFFSET = 772;
+    static const int SIDE_OFFSET = 780;
+
+    static const std::array<uint64_t, NUM_KEYS> keys;
+
+public:
+    static uint64_t piece_key(Piece piece, int index);
+    static uint64_t castling_key(int right); // 0: white oo, 1: white ooo, 2: black oo, 3: black ooo
+    static uint64_t en_passant_key(int file);
+    static uint64_t side_key();
+};
+
+#endif
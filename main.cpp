@@ -2,7 +2,18 @@
 #include "chess/gui.h"
 #include "chess/game.h"
 #include "testing/test_cases.h"
+#include "testing/bench.h"
+#include "testing/match.h"
+#include "testing/epd_suite.h"
+#include "testing/analysis.h"
 #include "chess/utils.h"
+#include "bot/syzygy.h"
+#include "bot/tuner.h"
+#include "bot/datagen.h"
+#include "bot/opening_book.h"
+#include "chess/packed_position.h"
+#include <string>
+#include <vector>
 
 void test() {
     run_all_test_cases();
@@ -30,9 +41,76 @@ void play() {
     close_gui();
 }
 
-int main() {
-    // test();
+void usage() {
+    std::cout << "Usage: app [--syzygy <directory>] [command]" << std::endl;
+    std::cout << "  play             play against Pawn Cena (default)" << std::endl;
+    std::cout << "  test             run the test cases" << std::endl;
+    std::cout << "  bench [depth]    search the bench positions, print node count and speed" << std::endl;
+    std::cout << "  match [key=value ...]  play two bot configurations against each other (see testing/match.h)" << std::endl;
+    std::cout << "  analyze [\"<FEN>\"] [key=value ...]  show the best lines of a position (see testing/analysis.h)" << std::endl;
+    std::cout << "  mate \"<FEN>\" [key=value ...]  find the shortest forced mate by checks (see testing/analysis.h)" << std::endl;
+    std::cout << "  suite <file.epd> [key=value ...]  solve an EPD test suite with bm/am moves (see testing/epd_suite.h)" << std::endl;
+    std::cout << "  book <games.pgn> [book.bin] [plies]  build a Polyglot opening book from a PGN database" << std::endl;
+    std::cout << "  pack <input> <output.bin>  convert FEN/EPD lines or PGN games to packed positions" << std::endl;
+    std::cout << "  datagen [key=value ...]  generate self-play training positions (see bot/datagen.h)" << std::endl;
+    std::cout << "  tune data=<file> [key=value ...]  tune the evaluation weights on labelled positions (see bot/tuner.h)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
     reset_debug_log();
-    play();
+
+    // Options: --syzygy <directory>. Everything else is the command and its arguments.
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--syzygy" && i + 1 < argc) {
+            if (!init_syzygy(argv[++i])) {
+                std::cerr << "Could not load Syzygy tablebases from " << argv[i] << std::endl;
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    std::string command = args.empty() ? "play" : args[0];
+    if (command == "play") {
+        play();
+    } else if (command == "test") {
+        test();
+    } else if (command == "bench") {
+        int depth = (args.size() > 1) ? std::stoi(args[1]) : 4;
+        run_bench(depth);
+    } else if (command == "match") {
+        run_match(std::vector<std::string>(args.begin() + 1, args.end()));
+    } else if (command == "analyze") {
+        run_analysis(std::vector<std::string>(args.begin() + 1, args.end()));
+    } else if (command == "mate") {
+        run_mate_analysis(std::vector<std::string>(args.begin() + 1, args.end()));
+    } else if (command == "suite") {
+        run_epd_suite(std::vector<std::string>(args.begin() + 1, args.end()));
+    } else if (command == "book" && args.size() > 1) {
+        std::string book_path = (args.size() > 2) ? args[2] : "book.bin";
+        int plies = (args.size() > 3) ? std::stoi(args[3]) : 16;
+        long entries = build_opening_book(args[1], book_path, plies);
+        if (entries < 0) {
+            std::cerr << "Could not build " << book_path << " from " << args[1] << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << entries << " entries to " << book_path << std::endl;
+    } else if (command == "pack" && args.size() > 2) {
+        long records = convert_to_packed(args[1], args[2]);
+        if (records < 0) {
+            std::cerr << "Could not convert " << args[1] << " to " << args[2] << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << records << " positions to " << args[2] << std::endl;
+    } else if (command == "datagen") {
+        run_datagen(std::vector<std::string>(args.begin() + 1, args.end()));
+    } else if (command == "tune") {
+        run_tuner(std::vector<std::string>(args.begin() + 1, args.end()));
+    } else {
+        usage();
+        return 1;
+    }
     return 0;
 }
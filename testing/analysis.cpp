@@ -0,0 +1,114 @@
+#include "analysis.h"
+#include "../bot/driver.h"
+#include "../bot/bitbase.h"
+#include "../bot/mate_search.h"
+#include "../chess/notation.h"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+using std::cout, std::endl;
+
+std::string format_pv_line(Board& board, Color player, const PvLine& line, double material_weight) {
+    char score[32];
+    if (std::abs(line.score) > 900000) {
+        // Mate scores are 1000000 - ply of the mate
+        int plies = 1000000 - (int) std::round(std::abs(line.score));
+        std::snprintf(score, sizeof(score), "#%s%d", line.score < 0 ? "-" : "", (plies + 1) / 2);
+    } else {
+        std::snprintf(score, sizeof(score), "%+.2f", line.score / material_weight);
+    }
+
+    std::string text = score;
+    Board position = board;
+    Color player_to_move = player;
+    for (const std::string& notation : line.moves) {
+        Move move(notation);
+        text += " " + move_to_san(position, move, player_to_move);
+        position.update_move(move, player_to_move);
+        player_to_move = (player_to_move == WHITE) ? BLACK : WHITE;
+    }
+    return text;
+}
+
+void run_analysis(const std::vector<std::string>& args) {
+    std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    std::map<std::string, std::string> options;
+    for (const std::string& arg : args) {
+        size_t equals = arg.find('=');
+        if (equals == std::string::npos || arg.find('/') != std::string::npos) {
+            fen = arg;
+        } else {
+            options[arg.substr(0, equals)] = arg.substr(equals + 1);
+        }
+    }
+
+    double seconds = options.count("time") ? std::stod(options["time"]) : 0.0;
+    uint64_t nodes = options.count("nodes") ? std::stoull(options["nodes"]) : 0;
+    int depth = options.count("depth") ? std::stoi(options["depth"]) : ((seconds > 0.0 || nodes > 0) ? 64 : 5);
+    int multi_pv = options.count("multipv") ? std::stoi(options["multipv"]) : 1;
+
+    init_bitbases();
+
+    Board board(fen);
+    Color player = (fen.find(" b ") != std::string::npos) ? BLACK : WHITE;
+    EvalParams eval_params;
+    load_eval_params("eval.params", eval_params);
+    Bot bot(depth);
+    bot.set_eval_params(eval_params);
+    bot.set_search_limits(seconds, nodes);
+    bot.set_multi_pv(multi_pv);
+    bot.request_move(board, player);
+
+    for (const IterationStats& iteration : bot.get_search_stats().iterations) {
+        for (size_t i = 0; i < iteration.lines.size(); i++) {
+            char prefix[96];
+            std::snprintf(prefix, sizeof(prefix), "depth %2d  line %d  nodes %10llu  time %7.3f  ", iteration.depth,
+                          (int) i + 1, (unsigned long long) iteration.nodes, iteration.seconds);
+            cout << prefix << format_pv_line(board, player, iteration.lines[i], eval_params.material_weight) << endl;
+        }
+    }
+}
+
+void run_mate_analysis(const std::vector<std::string>& args) {
+    std::string fen;
+    std::map<std::string, std::string> options;
+    for (const std::string& arg : args) {
+        size_t equals = arg.find('=');
+        if (equals == std::string::npos || arg.find('/') != std::string::npos) {
+            fen = arg;
+        } else {
+            options[arg.substr(0, equals)] = arg.substr(equals + 1);
+        }
+    }
+    if (fen.empty()) {
+        std::cerr << "mate: a FEN is required" << endl;
+        return;
+    }
+
+    double seconds = options.count("time") ? std::stod(options["time"]) : 0.0;
+    uint64_t nodes = options.count("nodes") ? std::stoull(options["nodes"]) : 0;
+    int max_moves = options.count("moves") ? std::stoi(options["moves"]) : 5;
+
+    Board board(fen);
+    Color player = (fen.find(" b ") != std::string::npos) ? BLACK : WHITE;
+    MateSearch mate_search;
+    mate_search.set_search_limits(seconds, nodes);
+    MateResult result = mate_search.search(board, player, max_moves);
+
+    char summary[96];
+    std::snprintf(summary, sizeof(summary), "nodes %10llu  time %7.3f  ", (unsigned long long) result.nodes,
+                  result.seconds);
+    if (!result.found) {
+        cout << summary << (result.aborted ? "search limit reached" : "no mate in " + std::to_string(max_moves))
+             << endl;
+        return;
+    }
+
+    PvLine line;
+    line.score = (player == WHITE ? 1 : -1) * (1000000.0 - (2 * result.moves - 1));
+    for (const Move& move : result.line) {
+        line.moves.push_back(move.get_move());
+    }
+    cout << summary << format_pv_line(board, player, line, 1.0) << endl;
+}
@@ -0,0 +1,20 @@
+#ifndef TESTING_ANALYSIS_H
+#define TESTING_ANALYSIS_H
+#include "../bot/search_stats.h"
+#include "../chess/board.h"
+#include "../chess/game.h"
+#include <string>
+#include <vector>
+
+// Analyzes one position and prints every iteration's lines (score and principal variation in SAN).
+// Arguments: "<FEN>" (default: the start position), then key=value pairs: depth=<n> multipv=<n> time=<s> nodes=<n>
+void run_analysis(const std::vector<std::string>& args);
+
+// Proves the shortest checking mate of one position with the mate finder and prints it.
+// Arguments: "<FEN>", then key=value pairs: moves=<max mate length> time=<s> nodes=<n>
+void run_mate_analysis(const std::vector<std::string>& args);
+
+// "+1.25 e4 e5 Nf3" style line: score in pawns from white's point of view (or "#N"/"#-N" for mates), SAN moves
+std::string format_pv_line(Board& board, Color player, const PvLine& line, double material_weight);
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef TESTING_BENCH_H
+#define TESTING_BENCH_H
+
+// Searches a fixed set of positions to 'depth' and prints the total node count (a signature that only changes
+// when search behavior does) and the nodes per second.
+void run_bench(int depth);
+
+#endif
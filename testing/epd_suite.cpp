@@ -0,0 +1,184 @@
+#include "epd_suite.h"
+#include "../chess/board.h"
+#include "../chess/game.h"
+#include "../chess/notation.h"
+#include "../bot/driver.h"
+#include "../bot/mate_search.h"
+#include "../bot/bitbase.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+using std::cout, std::endl;
+
+struct SuiteResult {
+    bool solved;
+    double time_to_solution; // seconds until the best move became (and stayed) a solution
+    uint64_t nodes;
+    std::string move_san;
+};
+
+// Coordinate notation of every SAN move in an operand ("Qd1+ Qh5" -> {"d8d1", "d8h5"})
+static std::vector<std::string> operand_moves(const EpdRecord& record, const std::string& opcode) {
+    std::vector<std::string> moves;
+    Board board(record.fen);
+    std::istringstream stream(record.get_operation(opcode));
+    std::string san;
+    while (stream >> san) {
+        Move move;
+        if (san_to_move(board, san, record.side_to_move, move)) {
+            moves.push_back(move.get_move());
+        }
+    }
+    return moves;
+}
+
+bool epd_move_solves(const EpdRecord& record, const std::string& move) {
+    if (record.has_operation("bm")) {
+        std::vector<std::string> best_moves = operand_moves(record, "bm");
+        if (std::find(best_moves.begin(), best_moves.end(), move) == best_moves.end()) {
+            return false;
+        }
+    }
+    if (record.has_operation("am")) {
+        std::vector<std::string> avoid_moves = operand_moves(record, "am");
+        if (std::find(avoid_moves.begin(), avoid_moves.end(), move) != avoid_moves.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void run_epd_suite(const std::vector<std::string>& args) {
+    std::map<std::string, std::string> options;
+    for (const std::string& arg : args) {
+        size_t equals = arg.find('=');
+        if (equals == std::string::npos) {
+            options["file"] = arg;
+        } else {
+            options[arg.substr(0, equals)] = arg.substr(equals + 1);
+        }
+    }
+    if (!options.count("file")) {
+        std::cerr << "suite: file=<suite.epd> is required" << endl;
+        return;
+    }
+
+    double seconds = options.count("time") ? std::stod(options["time"]) : 0.0;
+    uint64_t nodes = options.count("nodes") ? std::stoull(options["nodes"]) : 0;
+    bool limited = seconds > 0.0 || nodes > 0;
+    int depth = options.count("depth") ? std::stoi(options["depth"]) : (limited ? 64 : 4);
+    unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    int thread_count = options.count("threads") ? std::max(1, std::stoi(options["threads"])) : hardware_threads;
+
+    std::vector<EpdRecord> records;
+    for (const EpdRecord& record : load_epd_file(options["file"])) {
+        if (record.has_operation("bm") || record.has_operation("am") || record.has_operation("dm")) {
+            records.push_back(record);
+        }
+    }
+    if (records.empty()) {
+        std::cerr << "No positions with bm/am/dm in " << options["file"] << endl;
+        return;
+    }
+
+    init_bitbases();
+
+    std::vector<SuiteResult> results(records.size());
+    std::atomic<size_t> next_position(0);
+    std::mutex output_mutex;
+    auto report = [&](size_t i, const SuiteResult& result) {
+        const EpdRecord& record = records[i];
+        std::string id = record.has_operation("id") ? record.get_operation("id") : std::to_string(i + 1);
+        char line[200];
+        std::snprintf(line, sizeof(line), "%-16s %-8s %-8s %8.3f s %10llu nodes", id.c_str(),
+                      result.solved ? "solved" : "FAILED", result.move_san.c_str(),
+                      result.time_to_solution, (unsigned long long)result.nodes);
+        std::lock_guard<std::mutex> lock(output_mutex);
+        cout << line << endl;
+    };
+    auto worker = [&]() {
+        for (size_t i = next_position++; i < records.size(); i = next_position++) {
+            const EpdRecord& record = records[i];
+            Board board(record.fen);
+            SuiteResult& result = results[i];
+
+            if (record.has_operation("dm")) {
+                // Direct mate puzzles go to the mate finder: solved when it proves a mate at least as short
+                int mate_moves = std::stoi(record.get_operation("dm"));
+                MateSearch mate_search(4);
+                mate_search.set_search_limits(seconds, nodes);
+                MateResult mate = mate_search.search(board, record.side_to_move, mate_moves);
+                result.solved = mate.found && epd_move_solves(record, mate.line[0].get_move());
+                result.time_to_solution = mate.seconds;
+                result.nodes = mate.nodes;
+                result.move_san = mate.found ? move_to_san(board, mate.line[0], record.side_to_move) : "-";
+                report(i, result);
+                continue;
+            }
+
+            Bot bot(depth, 20.0, 1.0);
+            bot.set_search_limits(seconds, nodes);
+            Move move = bot.request_move(board, record.side_to_move);
+            const SearchStats& stats = bot.get_search_stats();
+
+            // Walk back over the iterations that already agreed with the final (solving) move
+            result.solved = epd_move_solves(record, move.get_move());
+            result.time_to_solution = 0.0;
+            result.nodes = stats.totals.nodes;
+            result.move_san = move_to_san(board, move, record.side_to_move);
+            if (result.solved) {
+                for (size_t j = stats.iterations.size(); j > 0; j--) {
+                    if (!epd_move_solves(record, stats.iterations[j - 1].best_move)) {
+                        break;
+                    }
+                    result.time_to_solution = stats.iterations[j - 1].seconds;
+                }
+            }
+            report(i, result);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; t++) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    int solved = 0;
+    uint64_t total_nodes = 0;
+    double total_time_to_solution = 0.0;
+    std::vector<double> solution_times;
+    for (const SuiteResult& result : results) {
+        total_nodes += result.nodes;
+        if (result.solved) {
+            solved++;
+            total_time_to_solution += result.time_to_solution;
+            solution_times.push_back(result.time_to_solution);
+        }
+    }
+    std::sort(solution_times.begin(), solution_times.end());
+
+    cout << "Solved          : " << solved << " / " << records.size() << endl;
+    cout << "Nodes searched  : " << total_nodes << endl;
+    if (solved > 0) {
+        cout << "Mean time (s)   : " << total_time_to_solution / solved << endl;
+    }
+
+    // Solve rate as a function of time
+    for (double limit : {0.01, 0.1, 0.5, 1.0, 5.0, 10.0, 60.0}) {
+        if (seconds > 0.0 && limit > seconds) {
+            break;
+        }
+        size_t count = std::upper_bound(solution_times.begin(), solution_times.end(), limit) - solution_times.begin();
+        char line[64];
+        std::snprintf(line, sizeof(line), "Solved <= %5.2f s: %zu", limit, count);
+        cout << line << endl;
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef TESTING_EPD_SUITE_H
+#define TESTING_EPD_SUITE_H
+#include "../chess/epd.h"
+#include <string>
+#include <vector>
+
+// Tactical test suite runner (WAC, STS, ...): searches every EPD position with a 'bm' (best move) or 'am' (avoid
+// move) opcode and reports how many were solved and how quickly. Positions with a 'dm' (direct mate in N) opcode
+// are proven with the mate finder instead of the full search. Arguments are key=value pairs:
+//   file=<suite.epd>  time=<seconds per position>  nodes=<n>  depth=<n>  threads=<n>
+void run_epd_suite(const std::vector<std::string>& args);
+
+// Whether 'move' (coordinate notation) satisfies the record's bm/am operations.
+bool epd_move_solves(const EpdRecord& record, const std::string& move);
+
+#endif
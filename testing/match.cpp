@@ -0,0 +1,233 @@
+#include "match.h"
+#include "../chess/board.h"
+#include "../chess/game.h"
+#include "../chess/epd.h"
+#include "../chess/pgn.h"
+#include "../bot/driver.h"
+#include "../bot/bitbase.h"
+#include "../bot/numa.h"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+using std::cout, std::endl;
+
+struct EngineConfig {
+    int depth = 4;
+    uint64_t nodes = 0;
+    double seconds = 0.0;
+    EvalParams eval_params;
+    PruningParams pruning;
+    ExtensionParams extensions;
+};
+
+int MatchScore::games() const {
+    return wins + draws + losses;
+}
+
+double MatchScore::score() const {
+    return games() == 0 ? 0.5 : (wins + 0.5 * draws) / games();
+}
+
+static double score_to_elo(double score) {
+    score = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+static double elo_to_score(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+// Per-game variance of the score around its mean (trinomial: win 1, draw 1/2, loss 0)
+static double score_variance(const MatchScore& result) {
+    double s = result.score();
+    double n = result.games();
+    return (result.wins * (1.0 - s) * (1.0 - s) + result.draws * (0.5 - s) * (0.5 - s) + result.losses * s * s) / n;
+}
+
+double MatchScore::elo() const {
+    return score_to_elo(score());
+}
+
+double MatchScore::elo_error() const {
+    if (games() == 0) {
+        return 0.0;
+    }
+    double margin = 1.96 * std::sqrt(score_variance(*this) / games());
+    return (score_to_elo(score() + margin) - score_to_elo(score() - margin)) / 2.0;
+}
+
+// Normal approximation to the trinomial GSPRT log-likelihood ratio of H1 (elo1) against H0 (elo0)
+double MatchScore::sprt_llr(double elo0, double elo1) const {
+    if (games() == 0) {
+        return 0.0;
+    }
+    double variance = score_variance(*this);
+    if (variance <= 0.0) {
+        return 0.0;
+    }
+    double s0 = elo_to_score(elo0);
+    double s1 = elo_to_score(elo1);
+    return games() * (s1 - s0) * (2.0 * score() - s0 - s1) / (2.0 * variance);
+}
+
+static Bot make_bot(const EngineConfig& config) {
+    Bot bot(config.depth);
+    bot.set_eval_params(config.eval_params);
+    bot.set_search_limits(config.seconds, config.nodes);
+    bot.set_pruning_params(config.pruning);
+    bot.set_extension_params(config.extensions);
+    return bot;
+}
+
+void run_match(const std::vector<std::string>& args) {
+    std::map<std::string, std::string> options;
+    for (const std::string& arg : args) {
+        size_t equals = arg.find('=');
+        if (equals == std::string::npos) {
+            std::cerr << "Ignoring match argument '" << arg << "' (expected key=value)" << endl;
+            continue;
+        }
+        options[arg.substr(0, equals)] = arg.substr(equals + 1);
+    }
+    auto option = [&](const std::string& key, const std::string& fallback) {
+        return options.count(key) ? options[key] : fallback;
+    };
+
+    EngineConfig engines[2];
+    const char* prefixes[2] = {"a.", "b."};
+    for (int i = 0; i < 2; i++) {
+        std::string prefix = prefixes[i];
+        engines[i].depth = std::stoi(option(prefix + "depth", "4"));
+        if (options.count(prefix + "params") && !load_eval_params(options[prefix + "params"], engines[i].eval_params)) {
+            std::cerr << "Could not load parameters from " << options[prefix + "params"] << endl;
+            return;
+        }
+        engines[i].eval_params.material_weight = std::stod(option(prefix + "material", std::to_string(engines[i].eval_params.material_weight)));
+        engines[i].eval_params.king_safety_weight = std::stod(option(prefix + "king_safety", std::to_string(engines[i].eval_params.king_safety_weight)));
+        engines[i].nodes = std::stoull(option(prefix + "nodes", "0"));
+        engines[i].seconds = std::stod(option(prefix + "time", "0"));
+        PruningParams& pruning = engines[i].pruning;
+        pruning.futility_margin = std::stod(option(prefix + "futility", std::to_string(pruning.futility_margin)));
+        pruning.reverse_futility_margin = std::stod(option(prefix + "reverse_futility", std::to_string(pruning.reverse_futility_margin)));
+        pruning.razor_margin = std::stod(option(prefix + "razor", std::to_string(pruning.razor_margin)));
+        ExtensionParams& extensions = engines[i].extensions;
+        extensions.check = std::stoi(option(prefix + "check_extension", std::to_string(extensions.check)));
+        extensions.recapture = std::stoi(option(prefix + "recapture_extension", std::to_string(extensions.recapture)));
+        extensions.singular = std::stoi(option(prefix + "singular_extension", std::to_string(extensions.singular)));
+        extensions.max_per_path = std::stoi(option(prefix + "max_extensions", std::to_string(extensions.max_per_path)));
+    }
+
+    int total_games = std::stoi(option("games", "100"));
+    int max_plies = std::stoi(option("plies", "400"));
+    unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    int thread_count = std::max(1, std::stoi(option("threads", std::to_string(hardware_threads))));
+    ThreadAffinity affinity = AFFINITY_NONE;
+    if (!parse_thread_affinity(option("affinity", "none"), affinity)) {
+        std::cerr << "Unknown affinity '" << options["affinity"] << "' (expected none, compact or spread)" << endl;
+        return;
+    }
+    double elo0 = std::stod(option("elo0", "0"));
+    double elo1 = std::stod(option("elo1", "5"));
+    double alpha = std::stod(option("alpha", "0.05"));
+    double beta = std::stod(option("beta", "0.05"));
+    double lower_bound = std::log(beta / (1.0 - alpha));
+    double upper_bound = std::log((1.0 - beta) / alpha);
+    std::string pgn_path = option("pgn", "");
+
+    std::vector<std::string> openings;
+    if (options.count("openings")) {
+        for (const EpdRecord& record : load_epd_file(options["openings"])) {
+            openings.push_back(record.fen);
+        }
+        if (openings.empty()) {
+            std::cerr << "No positions in " << options["openings"] << endl;
+            return;
+        }
+    } else {
+        openings.push_back("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    }
+
+    init_bitbases();
+
+    cout << "Match: " << total_games << " games, " << openings.size() << " openings, " << thread_count
+         << " threads, SPRT elo0=" << elo0 << " elo1=" << elo1 << " alpha=" << alpha << " beta=" << beta << endl;
+
+    std::atomic<int> next_game(0);
+    std::atomic<bool> stop(false);
+    std::mutex result_mutex;
+    MatchScore result = {0, 0, 0};
+    std::string verdict;
+
+    auto worker = [&](int thread_index) {
+        pin_current_thread(thread_index, affinity);
+        while (!stop) {
+            int game = next_game++;
+            if (game >= total_games) {
+                break;
+            }
+
+            // Games 2k and 2k+1 share an opening, with engine A playing white in the first
+            std::string fen = openings[(game / 2) % openings.size()];
+            bool a_is_white = (game % 2 == 0);
+            Board board(fen);
+            Color player = (fen.find(" b ") != std::string::npos) ? BLACK : WHITE;
+            Bot bot_a = make_bot(engines[0]);
+            Bot bot_b = make_bot(engines[1]);
+
+            PgnGame pgn;
+            pgn.set_tag("Event", "Pawn Cena match");
+            pgn.set_tag("Round", std::to_string(game + 1));
+            pgn.set_tag("White", a_is_white ? "A" : "B");
+            pgn.set_tag("Black", a_is_white ? "B" : "A");
+            pgn.set_tag("SetUp", "1");
+            pgn.set_tag("FEN", fen);
+            Color winner = a_is_white ? play_bot_game(board, player, bot_a, bot_b, max_plies, &pgn)
+                                      : play_bot_game(board, player, bot_b, bot_a, max_plies, &pgn);
+
+            std::lock_guard<std::mutex> lock(result_mutex);
+            if (!pgn_path.empty()) {
+                append_pgn(pgn_path, pgn);
+            }
+            if (winner == DRAW) {
+                result.draws++;
+            } else if ((winner == WHITE) == a_is_white) {
+                result.wins++;
+            } else {
+                result.losses++;
+            }
+
+            double llr = result.sprt_llr(elo0, elo1);
+            if (result.games() % 10 == 0 || result.games() == total_games) {
+                char line[160];
+                std::snprintf(line, sizeof(line), "Games %d: +%d =%d -%d  Elo %.1f +/- %.1f  LLR %.2f [%.2f, %.2f]",
+                              result.games(), result.wins, result.draws, result.losses,
+                              result.elo(), result.elo_error(), llr, lower_bound, upper_bound);
+                cout << line << endl;
+            }
+            if (verdict.empty() && (llr >= upper_bound || llr <= lower_bound)) {
+                verdict = (llr >= upper_bound) ? "H1 accepted" : "H0 accepted";
+                stop = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; i++) {
+        threads.emplace_back(worker, i);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "Final %d games: +%d =%d -%d  score %.3f  Elo %.1f +/- %.1f  LLR %.2f",
+                  result.games(), result.wins, result.draws, result.losses, result.score(),
+                  result.elo(), result.elo_error(), result.sprt_llr(elo0, elo1));
+    cout << line << endl;
+    cout << "SPRT: " << (verdict.empty() ? "inconclusive" : verdict) << endl;
+}
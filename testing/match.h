@@ -0,0 +1,30 @@
+#ifndef TESTING_MATCH_H
+#define TESTING_MATCH_H
+#include <string>
+#include <vector>
+
+// Bot-vs-bot match between two configurations, played headless on all cores. Arguments are key=value pairs:
+//   openings=<file.epd>  games=<n>  threads=<n>  plies=<max plies per game>  pgn=<file to append games to>
+//   affinity=<none|compact|spread>                                pins worker threads to CPUs (see bot/numa.h)
+//   a.depth a.params a.material a.king_safety a.nodes a.time (and b.*)   per-engine settings, time in seconds/move
+//   a.futility a.reverse_futility a.razor (and b.*)               pruning margins, 0 = off (see PruningParams)
+//   a.check_extension a.recapture_extension a.singular_extension a.max_extensions (and b.*)
+//                                                                 extensions in plies, 0 = off (see ExtensionParams)
+//   elo0 elo1 alpha beta                                          SPRT hypotheses and error rates
+// Every opening is played twice with colors reversed. Prints the score, Elo difference (95% interval) and the
+// SPRT log-likelihood ratio, and stops early once the SPRT accepts either hypothesis.
+void run_match(const std::vector<std::string>& args);
+
+struct MatchScore {
+    int wins;   // for engine A
+    int draws;
+    int losses;
+
+    int games() const;
+    double score() const; // points per game for engine A
+    double elo() const;
+    double elo_error() const; // half-width of the 95% confidence interval
+    double sprt_llr(double elo0, double elo1) const;
+};
+
+#endif
@@ -1,8 +1,30 @@
 #include "test_cases.h"
 #include "../chess/board.h"
 #include "../chess/game.h"
+#include "../bot/driver.h"
+#include "../bot/opening_book.h"
+#include "../bot/bitbase.h"
+#include "../chess/epd.h"
+#include "match.h"
+#include "../bot/tuner.h"
+#include "../chess/notation.h"
+#include "epd_suite.h"
+#include "../chess/pgn.h"
+#include "../chess/packed_position.h"
+#include "../chess/attack_tables.h"
+#include "../bot/transposition_table.h"
+#include "../bot/mate_search.h"
+#include "../bot/eval_cache.h"
+#include "../bot/numa.h"
+#include "../bot/datagen.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <thread>
+#include <utility>
 using std::cout, std::endl;
 
 void run_test_case(int test_index, bool passed) {
@@ -503,6 +525,874 @@ bool test14() {
     return true;
 }
 
+bool test15() {
+    // Black is in check, but can escape by blocking (not with the king)
+    Board blocked("k3R3/pp6/8/8/8/8/2r5/K7 b - - 0 1");
+    if (blocked.get_terminal_state(BLACK) != NOT_TERMINAL || !blocked.has_any_legal_move(BLACK)) {
+        return false;
+    }
+
+    // Back rank mate
+    Board mated("4R1k1/5ppp/8/8/8/8/8/K7 b - - 0 1");
+    if (mated.get_terminal_state(BLACK) != CHECKMATED || mated.has_any_legal_move(BLACK)) {
+        return false;
+    }
+
+    // Stalemated king in the corner
+    Board stalemated("k7/2Q5/1K6/8/8/8/8/8 b - - 0 1");
+    if (stalemated.get_terminal_state(BLACK) != STALEMATED || stalemated.has_any_legal_move(BLACK)) {
+        return false;
+    }
+
+    return true;
+}
+
+bool test16() {
+    // Transpositions hash the same, side to move does not
+    Board a;
+    Board b;
+    bool ta = true;
+    bool tb = true;
+    if (!valid(a, ta, "g1f3") || !valid(a, ta, "g8f6") || !valid(a, ta, "b1c3")) { return false; }
+    if (!valid(b, tb, "b1c3") || !valid(b, tb, "g8f6") || !valid(b, tb, "g1f3")) { return false; }
+    if (a.get_hash(BLACK) != b.get_hash(BLACK) || a.get_hash(BLACK) == a.get_hash(WHITE)) {
+        return false;
+    }
+
+    // Write a tiny book: two moves from the start position, plus an unrelated entry
+    Board start;
+    vector<std::pair<uint64_t, uint16_t>> entries = {
+        {start.get_hash(WHITE), OpeningBook::encode_move(Move("d2d4"), start, WHITE)},
+        {start.get_hash(WHITE), OpeningBook::encode_move(Move("e2e4"), start, WHITE)},
+        {a.get_hash(BLACK), OpeningBook::encode_move(Move("e7e5"), a, BLACK)},
+    };
+    std::sort(entries.begin(), entries.end());
+    std::string path = "test_book.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        for (auto& entry : entries) {
+            uint16_t weight = (entry.second == OpeningBook::encode_move(Move("e2e4"), start, WHITE)) ? 10 : 1;
+            unsigned char bytes[16] = {0};
+            for (int i = 0; i < 8; i++) { bytes[i] = (entry.first >> (56 - 8 * i)) & 0xFF; }
+            bytes[8] = entry.second >> 8;
+            bytes[9] = entry.second & 0xFF;
+            bytes[10] = weight >> 8;
+            bytes[11] = weight & 0xFF;
+            out.write(reinterpret_cast<char*>(bytes), 16);
+        }
+    }
+
+    OpeningBook book(path);
+    std::remove(path.c_str());
+    if (!book.is_open() || book.size() != 3) {
+        return false;
+    }
+
+    // Best move selection takes the heaviest entry, and the bot plays it without searching
+    Bot bot(1);
+    bot.set_opening_book(&book, 4, BOOK_BEST_MOVE);
+    if (bot.request_move(start, WHITE).get_move() != "e2e4") {
+        return false;
+    }
+
+    // Positions not in the book fall through to the search
+    Move book_move;
+    std::mt19937_64 rng(1);
+    if (book.probe(a, WHITE, BOOK_BEST_MOVE, rng, book_move)) {
+        return false;
+    }
+
+    return true;
+}
+
+bool test17() {
+    // Rook pawn with the defending king in the corner is a draw
+    Board rook_pawn("7k/8/8/8/8/8/7P/7K w - - 0 1");
+    if (probe_bitbase(rook_pawn, WHITE) != BITBASE_DRAW) { return false; }
+
+    // Unstoppable pawn
+    Board runner("8/4P3/8/8/8/8/k7/4K3 w - - 0 1");
+    if (probe_bitbase(runner, WHITE) != BITBASE_WIN) { return false; }
+
+    // Black to move is stalemated
+    Board stalemate("4k3/4P3/4K3/8/8/8/8/8 b - - 0 1");
+    if (probe_bitbase(stalemate, BLACK) != BITBASE_DRAW) { return false; }
+
+    // Hanging rook: draw if black can take it, win if white gets to move first
+    Board hanging_rook("8/8/8/8/8/3k4/2R5/7K b - - 0 1");
+    if (probe_bitbase(hanging_rook, BLACK) != BITBASE_DRAW) { return false; }
+    if (probe_bitbase(hanging_rook, WHITE) != BITBASE_WIN) { return false; }
+
+    // Black queen vs. white king
+    Board black_queen("3qk3/8/8/8/8/8/8/4K3 w - - 0 1");
+    if (probe_bitbase(black_queen, WHITE) != BITBASE_LOSS) { return false; }
+    if (probe_bitbase(black_queen, BLACK) != BITBASE_WIN) { return false; }
+
+    // Not a bitbase ending
+    Board start;
+    if (probe_bitbase(start, WHITE) != BITBASE_UNKNOWN) { return false; }
+
+    return true;
+}
+
+bool test18() {
+    // EPD records: operations, quoted operands and FEN-style move counters
+    EpdRecord record;
+    if (!parse_epd("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - bm Bb5; id \"test; 1\";", record)) { return false; }
+    if (record.side_to_move != WHITE || record.get_operation("bm") != "Bb5" || record.get_operation("id") != "test; 1") { return false; }
+    if (record.fen != "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 0 1") { return false; }
+    if (!parse_epd("8/8/8/8/8/3k4/2R5/7K b - - 12 40", record) || record.fen != "8/8/8/8/8/3k4/2R5/7K b - - 12 40") { return false; }
+    if (parse_epd("# comment", record) || parse_epd("not a position", record)) { return false; }
+
+    // Node-limited search still returns a legal move and stops near the limit
+    Board board;
+    Bot bot(20, 20.0, 1.0);
+    bot.set_search_limits(0.0, 2000);
+    Move move = bot.request_move(board, WHITE);
+    if (!board.is_legal_move(move, WHITE)) { return false; }
+    if (bot.get_search_stats().totals.nodes > 2100 || bot.get_search_stats().iterations.empty()) { return false; }
+
+    // Match statistics: an even score is 0 Elo, a winning score favors H1
+    MatchScore even = {10, 20, 10};
+    MatchScore winning = {60, 20, 20};
+    if (std::abs(even.elo()) > 1e-9 || even.sprt_llr(0, 5) >= 0) { return false; }
+    if (winning.elo() <= 0 || winning.sprt_llr(0, 5) <= 0) { return false; }
+
+    return true;
+}
+
+bool test19() {
+    // Dataset lines in the common labelled-position formats
+    std::string fen;
+    Color side;
+    double result;
+    if (!parse_labelled_position("8/8/8/8/8/3k4/2R5/7K b - - 0 1 [0.5]", fen, side, result) || result != 0.5 || side != BLACK) { return false; }
+    if (!parse_labelled_position("8/8/8/8/8/3k4/2R5/7K w - - c9 \"1-0\";", fen, side, result) || result != 1.0) { return false; }
+    if (!parse_labelled_position("8/8/8/8/8/3k4/2R5/7K w - - 3 9 0-1", fen, side, result) || result != 0.0) { return false; }
+    if (fen != "8/8/8/8/8/3k4/2R5/7K w - - 3 9") { return false; }
+    if (parse_labelled_position("8/8/8/8/8/3k4/2R5/7K w - - 0 1", fen, side, result)) { return false; }
+
+    // Quiescence plays out the hanging rook: black is to move and takes it
+    Bot bot(1, 20.0, 1.0);
+    Board hanging("8/8/8/8/8/3k4/2R5/7K b - - 0 1");
+    Board leaf;
+    double score = bot.quiescence(hanging, BLACK, -1e9, 1e9, &leaf);
+    if (leaf.get_eval_features().rooks != 0 || score > 1.0) { return false; }
+
+    // Parameter files round-trip, and the error is lowest for the parameters that match the results
+    EvalParams params;
+    params.queen_value = 9.5;
+    if (!save_eval_params("test_eval.params", params)) { return false; }
+    EvalParams loaded;
+    bool loaded_ok = load_eval_params("test_eval.params", loaded);
+    std::remove("test_eval.params");
+    if (!loaded_ok || loaded.queen_value != 9.5) { return false; }
+
+    std::vector<TuningPosition> positions = {{hanging.get_eval_features(), 1.0}, {leaf.get_eval_features(), 0.5}};
+    EvalParams no_material = params;
+    no_material.material_weight = 0.0;
+    if (tuning_error(positions, params, 1.0, 2) >= tuning_error(positions, no_material, 1.0, 2)) { return false; }
+
+    return true;
+}
+
+bool test20() {
+    // SAN generation: pieces, disambiguation, captures, promotions, castling and mate
+    Board start;
+    if (move_to_san(start, Move("g1f3"), WHITE) != "Nf3" || move_to_san(start, Move("e2e4"), WHITE) != "e4") { return false; }
+    Board knights("4k3/8/8/8/8/8/8/1N2KN2 w - - 0 1");
+    if (move_to_san(knights, Move("b1d2"), WHITE) != "Nbd2") { return false; }
+    Board rooks("4k3/8/8/R7/8/8/8/R3K3 w - - 0 1");
+    if (move_to_san(rooks, Move("a1a3"), WHITE) != "R1a3") { return false; }
+    Board mate("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    if (move_to_san(mate, Move("a1a8"), WHITE) != "Ra8#") { return false; }
+    Board promotion("1n6/P7/8/8/8/8/k7/6K1 w - - 0 1");
+    if (move_to_san(promotion, Move("a7a8"), WHITE) != "a8=Q+" || move_to_san(promotion, Move("a7b8pN"), WHITE) != "axb8=N") { return false; }
+    Board castling("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+    if (move_to_san(castling, Move("oo"), WHITE) != "O-O") { return false; }
+
+    // SAN parsing, including castling with zeros and missing '='
+    Move move;
+    if (!san_to_move(castling, "0-0-0", WHITE, move) || move.get_move() != "ooo") { return false; }
+    if (!san_to_move(promotion, "axb8N", WHITE, move) || move.get_move() != "a7b8pN") { return false; }
+    if (!san_to_move(knights, "Nbd2", WHITE, move) || move.get_move() != "b1d2") { return false; }
+    if (san_to_move(knights, "Nd2", WHITE, move) || san_to_move(start, "Nf6", WHITE, move)) { return false; }
+
+    // Suite scoring with best and avoid moves
+    EpdRecord record;
+    parse_epd("6k1/5ppp/8/8/8/8/8/R5K1 w - - bm Ra8#; id \"mate\";", record);
+    if (!epd_move_solves(record, "a1a8") || epd_move_solves(record, "a1a7")) { return false; }
+    parse_epd("6k1/5ppp/8/8/8/8/8/R5K1 w - - am Ra7;", record);
+    if (epd_move_solves(record, "a1a7") || !epd_move_solves(record, "a1a8")) { return false; }
+
+    return true;
+}
+
+bool test21() {
+    // Export: seven tag roster, numbered movetext, result
+    PgnGame game;
+    game.set_tag("Event", "Test");
+    game.moves = {"e4", "e5", "Nf3", "Nc6"};
+    game.result = "1-0";
+    std::string text = format_pgn(game);
+    if (text.find("[Event \"Test\"]\n[Site \"?\"]") != 0 || text.find("1. e4 e5 2. Nf3 Nc6 1-0") == std::string::npos) { return false; }
+
+    // Streaming reader: comments, NAGs, variations, escape lines, missing result tokens
+    std::string path = "test_games.pgn";
+    {
+        std::ofstream out(path);
+        out << text;
+        out << "% escaped line\n[Event \"Second\"]\n[Result \"1/2-1/2\"]\n\n"
+            << "1. d4 {main line} d5 $1 (1... Nf6 2. c4 (2. Nf3) e6) 2. c4 ; comment\n2... e6\n\n"
+            << "[Event \"Third\"]\n\n1.e4 c5 0-1\n\n"
+            << "[Event \"Fourth\"]\n\n1. e4 e5 2. Nf3 Nc6 3. Bc4 Bc5 4. 0-0 *\n";
+    }
+    PgnReader reader(path);
+    vector<PgnGame> games;
+    PgnGame read_game;
+    while (reader.next(read_game)) {
+        games.push_back(read_game);
+    }
+    if (games.size() != 4 || games[0].moves != game.moves || games[0].result != "1-0") { std::remove(path.c_str()); return false; }
+    if (games[1].moves != vector<std::string>{"d4", "d5", "c4", "e6"} || games[1].result != "1/2-1/2") { std::remove(path.c_str()); return false; }
+    if (games[2].get_tag("Event") != "Third" || games[2].moves != vector<std::string>{"e4", "c5"}) { std::remove(path.c_str()); return false; }
+    if (games[3].moves.size() != 7 || games[3].moves[6] != "0-0") { std::remove(path.c_str()); return false; }
+
+    // Replay lands in the same position as playing the moves directly
+    Board board;
+    Color player;
+    vector<Move> moves;
+    Board expected;
+    bool turn = true;
+    if (!replay_pgn_game(games[1], board, player, moves) || moves.size() != 4 || player != WHITE) { std::remove(path.c_str()); return false; }
+    for (const char* move : {"d2d4", "d7d5", "c2c4", "e7e6"}) {
+        valid(expected, turn, move);
+    }
+    if (board.get_hash(WHITE) != expected.get_hash(WHITE)) { std::remove(path.c_str()); return false; }
+
+    // Castling written with zeros replays like "O-O"
+    if (!replay_pgn_game(games[3], board, player, moves) || moves.size() != 7 || moves[6].get_move() != "oo") {
+        std::remove(path.c_str());
+        return false;
+    }
+
+    // A book built from the games plays the winner's (and drawer's) moves, never the loser's
+    long entries = build_opening_book(path, "test_book.bin", 4);
+    std::remove(path.c_str());
+    OpeningBook book("test_book.bin");
+    std::remove("test_book.bin");
+    if (entries != 7 || !book.is_open()) { return false; }
+    Board start;
+    Move book_move;
+    std::mt19937_64 rng(1);
+    if (!book.probe(start, WHITE, BOOK_BEST_MOVE, rng, book_move) || book_move.get_move() != "e2e4") { return false; }
+
+    return true;
+}
+
+bool test22() {
+    // Round trip keeps pieces, side to move, castling, en passant and move counters
+    Board board("r3k2r/pp3ppp/8/3pP3/8/8/PPP2PPP/R3K2R w Kq d6 3 17");
+    PackedPosition packed = pack_position(board, WHITE, -125, PACKED_DRAW);
+    Color side_to_move;
+    Board unpacked = unpack_position(packed, side_to_move);
+    if (side_to_move != WHITE || unpacked.get_hash(WHITE) != board.get_hash(WHITE)) { return false; }
+    if (unpacked.get_en_passant_square() != 43 || unpacked.get_draw_move_counter() != 3 || unpacked.get_ply_count() != 32) { return false; }
+    if (packed.score != -125 || packed.result != PACKED_DRAW) { return false; }
+
+    // EPD conversion with results and side-to-move relative "ce" scores, read back through the mapped file
+    {
+        std::ofstream out("test_positions.epd");
+        out << "r3k2r/pp3ppp/8/3pP3/8/8/PPP2PPP/R3K2R w Kq d6 3 17 [1.0]\n";
+        out << "8/8/8/8/8/3k4/2R5/7K b - - ce -450; c9 \"0-1\";\n";
+        out << "not a position\n";
+    }
+    std::remove("test_positions.bin");
+    long records = convert_to_packed("test_positions.epd", "test_positions.bin");
+    std::remove("test_positions.epd");
+    PackedPositionFile file("test_positions.bin");
+    std::remove("test_positions.bin");
+    if (records != 2 || !file.is_open() || file.size() != 2) { return false; }
+    if (file[0].result != PACKED_WHITE_WIN || file[1].result != PACKED_BLACK_WIN || file[1].score != 450) { return false; }
+    Board second = file.board(1, side_to_move);
+    if (side_to_move != BLACK || second.get_hash(BLACK) != Board("8/8/8/8/8/3k4/2R5/7K b - - 0 1").get_hash(BLACK)) { return false; }
+
+    return true;
+}
+
+bool test23() {
+    // Move codes and mate distances survive the table
+    for (const char* notation : {"e2e4", "a7b8pN", "h2h1pR", "c7c8pB", "oo", "ooo"}) {
+        if (unpack_tt_move(pack_tt_move(Move(notation))).get_move() != notation) { return false; }
+    }
+    if (score_from_tt(score_to_tt(1000000 - 7, 3), 5) != 1000000 - 9 || score_from_tt(score_to_tt(-12.5, 3), 5) != -12.5) { return false; }
+
+    TranspositionTable tt(1);
+    TTEntry entry;
+    tt.store(42, 1.5, TT_LOWER, 3, Move("g1f3"));
+    if (!tt.probe(42, entry) || entry.score != 1.5 || entry.bound != TT_LOWER || unpack_tt_move(entry.move).get_move() != "g1f3") { return false; }
+    if (tt.probe(43, entry)) { return false; }
+
+    // Multi-PV: distinct root moves, best first, each line legal from the root
+    Board board("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    Bot bot(3, 20.0, 1.0);
+    bot.set_multi_pv(3);
+    if (bot.request_move(board, WHITE).get_move() != "a1a8") { return false; }
+    const IterationStats& iteration = bot.get_search_stats().iterations.back();
+    if (iteration.lines.size() != 3) { return false; }
+    for (size_t i = 0; i < iteration.lines.size(); i++) {
+        if (i > 0 && (iteration.lines[i].score > iteration.lines[i - 1].score || iteration.lines[i].moves[0] == iteration.lines[0].moves[0])) { return false; }
+        Board position = board;
+        Color player = WHITE;
+        for (const std::string& notation : iteration.lines[i].moves) {
+            if (!position.is_legal_move(Move(notation), player)) { return false; }
+            position.update_move(Move(notation), player);
+            player = (player == WHITE) ? BLACK : WHITE;
+        }
+    }
+
+    return true;
+}
+
+bool test24() {
+    // Every iteration reports a full-length legal PV starting with its best move
+    Board board("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+    Bot bot(4, 20.0, 1.0);
+    Move move = bot.request_move(board, WHITE);
+    const std::vector<IterationStats>& iterations = bot.get_search_stats().iterations;
+    if (iterations.size() != 4 || iterations.back().best_move != move.get_move()) { return false; }
+    for (const IterationStats& iteration : iterations) {
+        const std::vector<std::string>& pv = iteration.lines[0].moves;
+        if ((int) pv.size() != iteration.depth || pv[0] != iteration.best_move) { return false; }
+        Board position = board;
+        Color player = WHITE;
+        for (const std::string& notation : pv) {
+            if (!position.is_legal_move(Move(notation), player)) { return false; }
+            position.update_move(Move(notation), player);
+            player = (player == WHITE) ? BLACK : WHITE;
+        }
+    }
+
+    // The mate in 2 is reported with its forced line
+    Board mate("q3k3/8/8/8/8/7q/8/3K4 b - - 0 1");
+    Bot mate_bot(5, 20.0, 1.0);
+    mate_bot.request_move(mate, BLACK);
+    const IterationStats& mate_iteration = mate_bot.get_search_stats().iterations.back();
+    if (mate_iteration.lines[0].score > -900000 || mate_iteration.lines[0].moves.size() != 3) { return false; }
+    bool white_turn = false;
+    for (const std::string& notation : mate_iteration.lines[0].moves) {
+        if (!valid(mate, white_turn, notation)) { return false; }
+    }
+    if (mate.get_terminal_state(WHITE) != CHECKMATED) { return false; }
+
+    return true;
+}
+
+bool test25() {
+    // Back rank mate in 1
+    Board back_rank("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    MateSearch mate_search;
+    MateResult result = mate_search.search(back_rank, WHITE, 3);
+    if (!result.found || result.moves != 1 || result.line.size() != 1 || result.line[0].get_move() != "a1a8") {
+        return false;
+    }
+
+    // The quiet mate in 2 is out of scope, so the shortest mate by checks is in 3 (and none within 2)
+    Board queens("q3k3/8/8/8/8/7q/8/3K4 b - - 0 1");
+    if (mate_search.search(queens, BLACK, 2).found) { return false; }
+    result = mate_search.search(queens, BLACK, 5);
+    if (!result.found || result.moves != 3 || result.line.size() != 5) { return false; }
+    bool white_turn = false;
+    for (const Move& move : result.line) {
+        if (!valid(queens, white_turn, move.get_move())) { return false; }
+    }
+    if (queens.get_terminal_state(WHITE) != CHECKMATED) { return false; }
+
+    // No checking mate from the start position, and a node limit stops the search
+    Board start;
+    result = mate_search.search(start, WHITE, 10);
+    if (result.found || result.aborted) { return false; }
+    Board rooks("4k3/8/8/8/8/8/8/R3K2R w - - 0 1");
+    mate_search.set_search_limits(0.0, 500);
+    result = mate_search.search(rooks, WHITE, 10);
+    if (result.found || !result.aborted || result.nodes > 500) { return false; }
+
+    return true;
+}
+
+bool test26() {
+    // A bot kept between moves starts the next search with warm tables and needs fewer nodes than a new one
+    Board board("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+    Bot persistent(5, 20.0, 1.0);
+    persistent.request_move(board, WHITE);
+    const std::vector<std::string>& pv = persistent.get_search_stats().iterations.back().lines[0].moves;
+    Board next = board;
+    next.update_move(Move(pv[0]), WHITE);
+    next.update_move(Move(pv[1]), BLACK);
+
+    Bot fresh(5, 20.0, 1.0);
+    Move fresh_move = fresh.request_move(next, WHITE);
+    uint64_t fresh_nodes = fresh.get_search_stats().totals.nodes;
+    persistent.request_move(next, WHITE);
+    if (persistent.get_search_stats().totals.nodes >= fresh_nodes) { return false; }
+
+    // new_game forgets everything, so the bot searches exactly like a new one
+    persistent.new_game();
+    Move move = persistent.request_move(next, WHITE);
+    if (persistent.get_search_stats().totals.nodes != fresh_nodes || move.get_move() != fresh_move.get_move()) {
+        return false;
+    }
+
+    return true;
+}
+
+bool test27() {
+    // The pseudo-legal generator filtered move by move gives exactly the legal moves, and a move is rejected
+    // precisely when it would leave the own king in check
+    std::vector<std::pair<std::string, Color>> positions = {
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", WHITE},
+        {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", WHITE},
+        {"4k3/8/8/3Pp3/8/8/8/4K3 w - e6 0 1", WHITE},         // en passant
+        {"4k3/8/8/2KPp2r/8/8/8/8 w - e6 0 1", WHITE},         // en passant would expose the king
+        {"4k3/4r3/8/8/3p4/4P3/4K3/8 w - - 0 1", WHITE},       // pinned pawn may not capture
+        {"4k3/8/8/b7/8/8/3P4/4K3 w - - 0 1", WHITE},          // pawn pinned on a diagonal
+        {"3rk3/8/8/8/8/8/3PP3/3K1r2 w - - 0 1", WHITE},       // in check
+        {"1n2k3/P7/8/8/8/8/8/4K3 w - - 0 1", WHITE},          // promotion with capture
+        {"q6k/8/8/8/8/8/1N6/K7 w - - 0 1", WHITE},
+        {"rnbqkbnr/ppp1pppp/8/8/3p4/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1", BLACK},
+    };
+    for (auto& [fen, player] : positions) {
+        Board board(fen);
+        std::vector<std::string> legal;
+        for (const Move& move : board.get_legal_moves(player)) {
+            legal.push_back(move.get_move());
+        }
+        std::vector<std::string> filtered;
+        LegalityInfo info = board.get_legality_info(player);
+        for (Move& move : board.get_pseudo_legal_moves(player)) {
+            bool accepted = board.is_pseudo_legal_move_legal(move, player, info);
+            if (accepted == board.inspect_move(move, player).is_checked(player)) { return false; }
+            if (accepted) {
+                filtered.push_back(move.get_move());
+            }
+        }
+        std::sort(legal.begin(), legal.end());
+        std::sort(filtered.begin(), filtered.end());
+        if (legal != filtered) { return false; }
+    }
+
+    // En passant is generated unless it uncovers a check along the rank, and pinned pawns stay on their pin lines
+    auto has_move = [](const std::vector<Move>& moves, const std::string& notation) {
+        return std::any_of(moves.begin(), moves.end(), [&](const Move& move) { return move.get_move() == notation; });
+    };
+    Board en_passant("4k3/8/8/3Pp3/8/8/8/4K3 w - e6 0 1");
+    if (!has_move(en_passant.get_legal_moves(WHITE), "d5e6")) { return false; }
+    Board rank_pin("4k3/8/8/2KPp2r/8/8/8/8 w - e6 0 1");
+    if (has_move(rank_pin.get_legal_moves(WHITE), "d5e6") || rank_pin.is_legal_move(Move("d5e6"), WHITE)) { return false; }
+    std::vector<Move> moves;
+    Board file_pin("4k3/4r3/8/8/3p4/4P3/4K3/8 w - - 0 1");
+    if (has_move(file_pin.get_legal_moves(WHITE), "e3d4")) { return false; }
+    Board diagonal_pin("4k3/8/8/b7/8/8/3P4/4K3 w - - 0 1");
+    moves = diagonal_pin.get_legal_moves(WHITE);
+    if (has_move(moves, "d2d3") || has_move(moves, "d2d4")) { return false; }
+
+    return true;
+}
+
+bool test28() {
+    // The compile-time tables match plain coordinate arithmetic on every square
+    static_assert(KNIGHT_ATTACKS.targets[0].count == 2 && KING_ATTACKS.targets[27].count == 8, "attack tables");
+    for (int square = 0; square < 64; square++) {
+        int file = square % 8;
+        int rank = square / 8;
+        uint64_t knight = 0, king = 0, white_pawn = 0, black_pawn = 0;
+        for (int target = 0; target < 64; target++) {
+            int file_diff = std::abs(target % 8 - file);
+            int rank_diff = target / 8 - rank;
+            if ((file_diff == 1 && std::abs(rank_diff) == 2) || (file_diff == 2 && std::abs(rank_diff) == 1)) {
+                knight |= 1ULL << target;
+            }
+            if (file_diff <= 1 && std::abs(rank_diff) <= 1 && target != square) {
+                king |= 1ULL << target;
+            }
+            if (file_diff == 1 && rank_diff == 1) { white_pawn |= 1ULL << target; }
+            if (file_diff == 1 && rank_diff == -1) { black_pawn |= 1ULL << target; }
+        }
+        if (KNIGHT_ATTACKS.attacks[square] != knight || KING_ATTACKS.attacks[square] != king ||
+                PAWN_ATTACKS[WHITE].attacks[square] != white_pawn || PAWN_ATTACKS[BLACK].attacks[square] != black_pawn) {
+            return false;
+        }
+
+        // The target lists hold the same squares
+        for (const AttackTable* table : {&KNIGHT_ATTACKS, &KING_ATTACKS, &PAWN_ATTACKS[WHITE], &PAWN_ATTACKS[BLACK]}) {
+            uint64_t listed = 0;
+            for (int i = 0; i < table->targets[square].count; i++) {
+                listed |= 1ULL << table->targets[square].squares[i];
+            }
+            if (listed != table->attacks[square]) { return false; }
+        }
+    }
+
+    // Attack tests built on the tables
+    Board knight_check("4k3/8/8/8/8/3n4/8/4K3 w - - 0 1");
+    Board pawn_check("4k3/8/8/8/8/8/3p4/4K3 w - - 0 1");
+    Board king_near("8/8/8/8/8/3k4/8/4K3 w - - 0 1");
+    if (!knight_check.is_checked(WHITE) || !pawn_check.is_checked(WHITE) || king_near.is_checked(WHITE)) {
+        return false;
+    }
+    if (king_near.get_legal_moves(WHITE).size() != 3) { return false; }
+
+    return true;
+}
+
+bool test29() {
+    // gives_check agrees with playing the move and looking, for every legal move of both sides
+    std::vector<std::string> fens = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "4k3/8/8/8/8/8/4B3/R3K2R w KQ - 0 1",           // castling into check
+        "4k3/8/2N5/8/4B3/8/4R3/4K3 w - - 0 1",          // discovered checks
+        "3k4/8/8/2KPp2r/8/8/8/8 w - e6 0 1",            // en passant
+        "1n1k4/P7/8/8/8/8/8/4K3 w - - 0 1",             // promotions
+        "q3k3/8/8/8/8/7q/8/3K4 b - - 0 1",
+        "r1bqkbnr/pppp1ppp/2n5/4p3/2B1P3/5Q2/PPPP1PPP/RNB1K1NR w KQkq - 2 3",
+    };
+    for (const std::string& fen : fens) {
+        for (Color player : {WHITE, BLACK}) {
+            Board board(fen);
+            Color opponent = (player == WHITE) ? BLACK : WHITE;
+            CheckInfo info = board.get_check_info(player);
+            for (Move& move : board.get_legal_moves(player)) {
+                if (board.gives_check(move, player, info) != board.inspect_move(move, player).is_checked(opponent)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    // The cached king squares follow king moves and castling
+    Board board("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+    board.update_move(Move("oo"), WHITE);
+    board.update_move(Move("e8d8"), BLACK);
+    board.update_move(Move("a1a8"), WHITE);
+    if (!board.is_checked(BLACK) || board.is_checked(WHITE)) { return false; }
+
+    return true;
+}
+
+bool test30() {
+    EvalParams params;
+
+    // Symmetric positions are level, mirrored ones score the other way round
+    if (Board().evaluate(params) != 0.0) { return false; }
+    Board position("r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/3P1N2/PPP2PPP/RNBQK2R w KQkq - 0 1");
+    Board mirrored("rnbqk2r/ppp2ppp/3p1n2/2b1p3/2B1P3/2N2N2/PPPP1PPP/R1BQK2R b KQkq - 0 1");
+    if (std::abs(position.evaluate(params) + mirrored.evaluate(params)) > 1e-9) { return false; }
+
+    // Mobility: a centralised knight sees more safe squares than one in the corner
+    EvalFeatures centre = Board("4k3/8/8/8/3N4/8/8/4K3 w - - 0 1").get_eval_features();
+    EvalFeatures corner = Board("4k3/8/8/8/8/8/8/N3K3 w - - 0 1").get_eval_features();
+    if (centre.knight_mobility != 8 || corner.knight_mobility != 2) { return false; }
+
+    // An undefended black knight attacked by the rook is hanging; defending it fixes that
+    if (Board("4k3/8/8/3n4/8/8/8/3RK3 w - - 0 1").get_eval_features().hanging_pieces != 1) { return false; }
+    if (Board("4k3/8/4p3/3n4/8/8/8/3RK3 w - - 0 1").get_eval_features().hanging_pieces != 0) { return false; }
+
+    // Pawn shield and attacks on the king zone
+    EvalFeatures shielded = Board("6k1/5ppp/8/8/8/8/5PPP/6K1 w - - 0 1").get_eval_features();
+    EvalFeatures broken = Board("6k1/5ppp/8/8/8/8/5PP1/6K1 w - - 0 1").get_eval_features();
+    if (shielded.pawn_shield != 0 || broken.pawn_shield != -1) { return false; }
+    EvalFeatures attacked = Board("6k1/5ppp/8/8/8/8/5PPP/r5K1 w - - 0 1").get_eval_features();
+    if (attacked.king_zone_attacks >= shielded.king_zone_attacks) { return false; }
+
+    // Every new weight is a parameter file field
+    params.hanging_piece_weight = 7.5;
+    if (!save_eval_params("test_eval.params", params)) { return false; }
+    EvalParams loaded;
+    bool ok = load_eval_params("test_eval.params", loaded) && loaded.hanging_piece_weight == 7.5;
+    std::remove("test_eval.params");
+    return ok;
+}
+
+bool test31() {
+    // Stored scores come back for their own key only
+    EvalCache cache(1);
+    double score = 0.0;
+    if (cache.probe(12345, score)) { return false; }
+    cache.store(12345, -3.25);
+    if (!cache.probe(12345, score) || score != -3.25) { return false; }
+    if (cache.probe(12345 + (1ULL << 40), score)) { return false; }
+
+    // A bot evaluates through a shared cache: a planted score for the start position is what quiescence sees
+    // (there are no captures to play), until new weights clear the cache
+    Board board;
+    Bot bot(2);
+    bot.set_eval_cache(&cache);
+    cache.store(board.get_hash(WHITE), 42.0);
+    double inf = std::numeric_limits<double>::infinity();
+    if (bot.quiescence(board, WHITE, -inf, inf) != 42.0) { return false; }
+    bot.set_eval_params(EvalParams());
+    if (bot.quiescence(board, WHITE, -inf, inf) != 0.0) { return false; }
+    if (!cache.probe(board.get_hash(WHITE), score) || score != 0.0) { return false; }
+
+    // Searches give the same answer with a cold and a warm cache
+    Board position("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+    Bot searcher(3);
+    std::string cold = searcher.request_move(position, WHITE).get_move();
+    searcher.new_game();
+    return searcher.request_move(position, WHITE).get_move() == cold;
+}
+
+bool test32() {
+    // With its margins set, pruning near the horizon searches fewer nodes than the default full search
+    Board board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10");
+    PruningParams on;
+    on.futility_margin = 2.0;
+    on.reverse_futility_margin = 1.5;
+    on.razor_margin = 3.0;
+    Bot pruned(4);
+    pruned.set_pruning_params(on);
+    pruned.request_move(board, WHITE);
+    uint64_t pruned_nodes = pruned.get_search_stats().totals.nodes;
+
+    Bot full(4);
+    full.request_move(board, WHITE);
+    if (pruned_nodes >= full.get_search_stats().totals.nodes) { return false; }
+
+    // Tactics are still found: a hanging queen is taken, and mate in one is still mate
+    Bot bot(4);
+    bot.set_pruning_params(on);
+    Board hanging("4k3/8/8/3q4/8/8/8/3RK3 w - - 0 1");
+    if (bot.request_move(hanging, WHITE).get_move() != "d1d5") { return false; }
+    Board mate("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    bot.new_game();
+    return bot.request_move(mate, WHITE).get_move() == "a1a8";
+}
+
+bool test33() {
+    // White mates in 2 with checks (Rd8+ Rxd8 Rxd8#), three plies deep: a depth-2 search only sees it when checks
+    // are extended
+    Board board("2r3k1/5ppp/8/8/8/8/3R1PPP/3R2K1 w - - 0 1");
+    Bot plain(2, 20.0, 1.0);
+    plain.request_move(board, WHITE);
+    if (plain.get_search_stats().iterations.back().score > 900000) { return false; }
+
+    Bot extended(2, 20.0, 1.0);
+    ExtensionParams checks;
+    checks.check = 1;
+    extended.set_extension_params(checks);
+    if (extended.request_move(board, WHITE).get_move() != "d2d8") { return false; }
+    if (extended.get_search_stats().iterations.back().score < 900000) { return false; }
+
+    // Every extension with a long per-path limit (and the deeper lines it allows) still plays a legal move
+    Board middlegame("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10");
+    Bot deep(4, 20.0, 1.0);
+    ExtensionParams generous;
+    generous.check = 1;
+    generous.recapture = 1;
+    generous.singular = 1;
+    generous.max_per_path = 6;
+    generous.singular_min_depth = 2;
+    deep.set_extension_params(generous);
+    return middlegame.is_legal_move(deep.request_move(middlegame, WHITE), WHITE);
+}
+
+bool test34() {
+    // Incremental hashes match hashing the position after the move: captures (including a rook taken on its corner),
+    // promotions, castling (which clears the en passant square), en passant captures and double pushes next to
+    // enemy pawns
+    const char* fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq - 0 10",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "r3k2r/1P4P1/8/3pP3/2p5/8/1p4p1/R3K2R b KQkq - 0 1",
+        "r3k2r/1P4P1/8/3pP3/2p5/8/1p4p1/R3K2R w KQkq d6 0 1",
+        "4k3/8/8/8/1p1p4/8/2P5/4K3 w - - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R b KQ - 1 8",
+    };
+    for (const char* fen : fens) {
+        Board board(fen);
+        Color player = (std::string(fen).find(" w ") != std::string::npos) ? WHITE : BLACK;
+        Color opponent = (player == WHITE) ? BLACK : WHITE;
+        uint64_t hash = board.get_hash(player);
+        for (Move& move : board.get_legal_moves(player)) {
+            if (board.hash_after_move(hash, move, player) != board.inspect_move(move, player).get_hash(opponent)) {
+                return false;
+            }
+        }
+    }
+
+    // After castling the old d6 square is gone, so black's c4 pawn adds no en passant key
+    Board castling("r3k2r/1P4P1/8/3pP3/2p5/8/1p4p1/R3K2R w KQkq d6 0 1");
+    Board castled("r3k2r/1P4P1/8/3pP3/2p5/8/1p4p1/R4RK1 b kq - 1 1");
+    Move castle("oo");
+    if (castling.hash_after_move(castling.get_hash(WHITE), castle, WHITE) != castled.get_hash(BLACK) ||
+            castling.inspect_move(castle, WHITE).get_en_passant_square() != -1) {
+        return false;
+    }
+
+    // Positions sharing a bucket all fit, and a full bucket keeps the deeper entries
+    TranspositionTable tt(1);
+    TTEntry entry;
+    for (uint64_t i = 1; i <= 4; i++) {
+        tt.store((i << 40) | 5, 1.0 * i, TT_EXACT, (int) i, Move("e2e4"));
+    }
+    for (uint64_t i = 1; i <= 4; i++) {
+        if (!tt.probe((i << 40) | 5, entry) || entry.score != 1.0 * i || entry.depth != (int) i) { return false; }
+    }
+    tt.store((9ULL << 40) | 5, 9.0, TT_LOWER, 9, Move("d2d4"));
+    if (tt.probe((1ULL << 40) | 5, entry) || !tt.probe((4ULL << 40) | 5, entry) || !tt.probe((9ULL << 40) | 5, entry)) {
+        return false;
+    }
+
+    // A moved table keeps its entries
+    TranspositionTable moved(std::move(tt));
+    return moved.probe((9ULL << 40) | 5, entry) && entry.bound == TT_LOWER && moved.hashfull() >= 0;
+}
+
+bool test35() {
+    std::vector<int> cpus = parse_cpu_list("0-3,8,10-11\n");
+    if (cpus != std::vector<int>{0, 1, 2, 3, 8, 10, 11}) { return false; }
+    ThreadAffinity affinity;
+    if (!parse_thread_affinity("spread", affinity) || affinity != AFFINITY_SPREAD || parse_thread_affinity("numa", affinity)) {
+        return false;
+    }
+
+    // Every pinned thread lands on a CPU of the topology, and unpinned ones on none
+    const NumaTopology& topology = numa_topology();
+    if (topology.nodes() < 1 || topology.cpus() < 1) { return false; }
+    for (int thread = 0; thread < 2 * topology.cpus() + 1; thread++) {
+        if (thread_cpu(thread, AFFINITY_NONE) != -1) { return false; }
+        for (ThreadAffinity mode : {AFFINITY_COMPACT, AFFINITY_SPREAD}) {
+            int cpu = thread_cpu(thread, mode);
+            bool known = false;
+            for (const std::vector<int>& node : topology.node_cpus) {
+                known = known || std::find(node.begin(), node.end(), cpu) != node.end();
+            }
+            if (!known) { return false; }
+        }
+    }
+
+    // Pinning a worker works on Linux even with a single node
+    bool pinned = false;
+    std::thread worker([&]() { pinned = pin_current_thread(1, AFFINITY_COMPACT); });
+    worker.join();
+#ifdef __linux__
+    if (!pinned) { return false; }
+#endif
+
+    // An interleaved table (node-local here on a single node) behaves like any other
+    TranspositionTable tt(1, TT_INTERLEAVED);
+    TTEntry entry;
+    tt.store(12345, 2.5, TT_EXACT, 3, Move("e2e4"));
+    if (!tt.probe(12345, entry) || entry.score != 2.5 || tt.get_placement() != TT_INTERLEAVED) { return false; }
+    tt.set_placement(TT_NODE_LOCAL);
+    if (tt.probe(12345, entry) || tt.get_placement() != TT_NODE_LOCAL) { return false; }
+
+    Board board;
+    Bot bot(3);
+    bot.set_hash_placement(TT_INTERLEAVED);
+    return bot.request_move(board, WHITE).get_move().size() >= 4;
+}
+
+bool test36() {
+    // Reference keys from the Polyglot book format specification
+    Board board;
+    if (board.get_hash(WHITE) != 0x463b96181691fc9cULL) { return false; }
+    board.update_move(Move("e2e4"), WHITE);
+    if (board.get_hash(BLACK) != 0x823c9b50fd114196ULL) { return false; }
+
+    const std::pair<const char*, uint64_t> positions[] = {
+        {"rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756b94461c50fb0ULL},
+        {"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662fafb965db29d4ULL},
+        {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22a48b5a8e47ff78ULL},
+        {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652a607ca3f242c1ULL},
+        {"rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00fdd303c946bdd9ULL},
+        {"rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3c8123ea7b067637ULL},
+        {"rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5c3f9b829b279560ULL},
+    };
+    for (const auto& position : positions) {
+        Board reference(position.first);
+        Color player = (std::string(position.first).find(" w ") != std::string::npos) ? WHITE : BLACK;
+        if (reference.get_hash(player) != position.second) { return false; }
+    }
+    return true;
+}
+
+bool test37() {
+    // Reads back every record of a tiny self-play run: a sane score, a decodable position and a game result
+    auto check_records = [](const std::string& path, bool cut_off) {
+        PackedPositionFile file(path);
+        if (!file.is_open() || file.size() == 0) { return false; }
+        bool finished_game = false;
+        for (size_t i = 0; i < file.size(); i++) {
+            const PackedPosition& record = file[i];
+            if (record.score < -32000 || record.score > 32000) { return false; }
+            if (record.result != PACKED_BLACK_WIN && record.result != PACKED_DRAW && record.result != PACKED_WHITE_WIN &&
+                    record.result != PACKED_NO_RESULT) {
+                return false;
+            }
+            // Games stopped at the ply limit are unfinished, never draws
+            if (cut_off && record.result != PACKED_NO_RESULT) { return false; }
+            finished_game = finished_game || record.result != PACKED_NO_RESULT;
+            Color side_to_move;
+            Board board = file.board(i, side_to_move);
+            if (board.get_legal_moves(side_to_move).empty()) { return false; }
+        }
+        return cut_off || finished_game;
+    };
+
+    std::string path = "test_datagen.bin";
+    std::remove(path.c_str());
+    run_datagen({"out=" + path, "games=2", "depth=1", "threads=1"});
+    bool played = check_records(path, false);
+    std::remove(path.c_str());
+
+    run_datagen({"out=" + path, "games=2", "depth=1", "threads=2", "random_plies=0", "min_ply=0", "plies=20"});
+    bool cut_off = check_records(path, true);
+    std::remove(path.c_str());
+    return played && cut_off;
+}
+
+// Leaf count of the legal move tree 'depth' plies deep
+static uint64_t perft(Board& board, Color player, int depth) {
+    if (depth == 0) {
+        return 1;
+    }
+    Color opponent = (player == WHITE) ? BLACK : WHITE;
+    uint64_t nodes = 0;
+    for (Move& move : board.get_legal_moves(player)) {
+        Board child = board.inspect_move(move, player);
+        nodes += perft(child, opponent, depth - 1);
+    }
+    return nodes;
+}
+
+bool test38() {
+    // Standard perft reference counts: start position, Kiwipete (castling, en passant and promotions) and
+    // positions 3-5 (en passant pins, promotions, castling after a rook is captured on its corner)
+    struct PerftCase {
+        const char* fen;
+        int depth;
+        uint64_t nodes;
+    };
+    const PerftCase cases[] = {
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4, 197281},
+        {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862},
+        {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 4, 43238},
+        {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3, 9467},
+        {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379},
+    };
+    for (const PerftCase& test : cases) {
+        Board board(test.fen);
+        Color player = (std::string(test.fen).find(" w ") != std::string::npos) ? WHITE : BLACK;
+        if (perft(board, player, test.depth) != test.nodes) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void run_all_test_cases() {
 
     // GAME TEST CASES
@@ -518,6 +1408,30 @@ void run_all_test_cases() {
     run_test_case(10, test10()); // fifty move rule draw
     run_test_case(11, test11()); // stalemate
     run_test_case(12, test12()); // en passant
+    run_test_case(15, test15()); // terminal state queries
+    run_test_case(16, test16()); // position hashing and opening book
+    run_test_case(17, test17()); // endgame bitbases
+    run_test_case(18, test18()); // EPD parsing, search limits and match statistics
+    run_test_case(19, test19()); // evaluation tuning
+    run_test_case(20, test20()); // SAN notation and EPD suite scoring
+    run_test_case(21, test21()); // PGN export, streaming reader and book building
+    run_test_case(22, test22()); // packed positions
+    run_test_case(23, test23()); // transposition table and multi-PV
+    run_test_case(24, test24()); // principal variation reporting
+    run_test_case(25, test25()); // mate finder
+    run_test_case(26, test26()); // persistent bot keeps its tables between moves
+    run_test_case(27, test27()); // pseudo-legal generation with deferred legality checks
+    run_test_case(28, test28()); // precomputed knight, king and pawn attack tables
+    run_test_case(29, test29()); // gives_check and cached king squares
+    run_test_case(30, test30()); // attack-map mobility, king safety and hanging pieces
+    run_test_case(31, test31()); // evaluation cache
+    run_test_case(32, test32()); // futility pruning, reverse futility and razoring
+    run_test_case(33, test33()); // check, recapture and singular extensions
+    run_test_case(34, test34()); // incremental child hashes and bucketed transposition table
+    run_test_case(35, test35()); // NUMA topology, thread pinning and table placement
+    run_test_case(36, test36()); // Polyglot reference hashes
+    run_test_case(37, test37()); // self-play training data
+    run_test_case(38, test38()); // perft against the standard reference counts
 
     // BOT TEST CASES
     run_test_case(13, test13()); // bot finds mate in 1